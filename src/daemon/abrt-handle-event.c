@@ -20,6 +20,8 @@
 #include <satyr/stacktrace.h>
 #include <satyr/distance.h>
 #include <satyr/abrt.h>
+#include <satyr/core/frame.h>
+#include <satyr/core/thread.h>
 
 #include "libabrt.h"
 #include <libreport/run_event.h>
@@ -27,12 +29,50 @@
 /* 70 % similarity */
 #define BACKTRACE_DUP_THRESHOLD 0.3
 
+/* A fingerprint of the crash thread of a core backtrace, attached to the
+ * problem as an annotation in the problem info cache when the problem is not
+ * a duplicate, so it never becomes a reported element:
+ *   VERSION BT_MTIME_SEC BT_MTIME_NSEC FRAMES UNKNOWN_FRAMES HASH...
+ *
+ * BT_MTIME is the modification time of the core backtrace the fingerprint
+ * was computed from; a fingerprint of a different core backtrace is ignored.
+ *
+ * HASHes are sorted FNV-1a hashes of function names of frames with a known
+ * function name.
+ *
+ * Frames with different function names are different in
+ * sr_distance(SR_DISTANCE_DAMERAU_LEVENSHTEIN), so at most
+ *   COMMON_HASHES + min(UNKNOWN_FRAMES_1, UNKNOWN_FRAMES_2)
+ * frames can be kept by the edits, which gives the lower bound of the distance
+ *   1 - kept / max(FRAMES_1, FRAMES_2)
+ *
+ * Candidates whose lower bound is above BACKTRACE_DUP_THRESHOLD are not
+ * duplicates and their backtraces are neither parsed nor compared.
+ */
+#define CRASH_THREAD_FINGERPRINT_ANNOTATION "crash_thread_fingerprint"
+#define FINGERPRINT_VERSION 2
+
+struct crash_thread_fingerprint
+{
+    struct timespec bt_mtime;
+    unsigned frames;
+    unsigned unknown_frames;
+    unsigned hash_count;
+    uint32_t hashes[];
+};
+
 static char *uid = NULL;
 static char *uuid = NULL;
 static struct sr_stacktrace *corebt = NULL;
 static char *type = NULL;
 static char *executable = NULL;
 static char *crash_dump_dup_name = NULL;
+static struct crash_thread_fingerprint *fingerprint = NULL;
+/* Statistics of core backtrace comparisons */
+static unsigned bt_compared = 0;
+static unsigned bt_pruned = 0;
+static unsigned long long bt_distance_us = 0;
+static problem_info_cache_t *problem_info_cache = NULL;
 
 static void dup_corebt_fini(void);
 
@@ -48,6 +88,178 @@ static char* load_backtrace(const struct dump_dir *dd)
         DD_FAIL_QUIETLY_ENOENT|DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
 }
 
+static uint32_t fnv1a_hash(const char *str)
+{
+    uint32_t hash = 2166136261u;
+    for (; *str != '\0'; ++str)
+    {
+        hash ^= (unsigned char)*str;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int uint32_cmp(const void *lhs, const void *rhs)
+{
+    const uint32_t l = *(const uint32_t *)lhs;
+    const uint32_t r = *(const uint32_t *)rhs;
+    return l < r ? -1 : (l > r);
+}
+
+static struct crash_thread_fingerprint *fingerprint_new(unsigned hash_count)
+{
+    struct crash_thread_fingerprint *fp = xzalloc(sizeof(*fp) + hash_count * sizeof(fp->hashes[0]));
+    fp->hash_count = hash_count;
+    return fp;
+}
+
+static struct crash_thread_fingerprint *fingerprint_from_thread(struct sr_core_thread *thread)
+{
+    unsigned frames = 0;
+    for (struct sr_core_frame *frame = thread->frames; frame != NULL; frame = frame->next)
+        ++frames;
+
+    struct crash_thread_fingerprint *fp = fingerprint_new(frames);
+    fp->frames = frames;
+    fp->hash_count = 0;
+
+    for (struct sr_core_frame *frame = thread->frames; frame != NULL; frame = frame->next)
+    {
+        if (frame->function_name == NULL)
+            ++fp->unknown_frames;
+        else
+            fp->hashes[fp->hash_count++] = fnv1a_hash(frame->function_name);
+    }
+
+    qsort(fp->hashes, fp->hash_count, sizeof(fp->hashes[0]), uint32_cmp);
+    return fp;
+}
+
+static char *fingerprint_to_str(const struct crash_thread_fingerprint *fp)
+{
+    struct strbuf *buf = strbuf_new();
+    strbuf_append_strf(buf, "%u %lld %ld %u %u", FINGERPRINT_VERSION,
+                       (long long)fp->bt_mtime.tv_sec, (long)fp->bt_mtime.tv_nsec,
+                       fp->frames, fp->unknown_frames);
+    for (unsigned i = 0; i < fp->hash_count; ++i)
+        strbuf_append_strf(buf, " %08x", fp->hashes[i]);
+    return strbuf_free_nobuf(buf);
+}
+
+static struct crash_thread_fingerprint *fingerprint_parse(const char *str)
+{
+    unsigned version, frames, unknown_frames;
+    long long bt_sec;
+    long bt_nsec;
+    int ofs = 0;
+    if (sscanf(str, "%u %lld %ld %u %u%n", &version, &bt_sec, &bt_nsec, &frames, &unknown_frames, &ofs) != 5
+     || version != FINGERPRINT_VERSION
+     || unknown_frames > frames)
+        return NULL;
+
+    struct crash_thread_fingerprint *fp = fingerprint_new(frames - unknown_frames);
+    fp->bt_mtime.tv_sec = bt_sec;
+    fp->bt_mtime.tv_nsec = bt_nsec;
+    fp->frames = frames;
+    fp->unknown_frames = unknown_frames;
+
+    str += ofs;
+    for (unsigned i = 0; i < fp->hash_count; ++i)
+    {
+        unsigned hash;
+        if (sscanf(str, " %8x%n", &hash, &ofs) != 1)
+        {
+            free(fp);
+            return NULL;
+        }
+        fp->hashes[i] = hash;
+        str += ofs;
+    }
+
+    return fp;
+}
+
+static float fingerprint_distance_lower_bound(const struct crash_thread_fingerprint *fp1,
+                                              const struct crash_thread_fingerprint *fp2)
+{
+    const unsigned max_frames = MAX(fp1->frames, fp2->frames);
+    if (max_frames == 0)
+        return 0;
+
+    /* Both hash arrays are sorted */
+    unsigned common = 0;
+    for (unsigned i = 0, j = 0; i < fp1->hash_count && j < fp2->hash_count; )
+    {
+        if (fp1->hashes[i] < fp2->hashes[j])
+            ++i;
+        else if (fp1->hashes[i] > fp2->hashes[j])
+            ++j;
+        else
+        {
+            ++common;
+            ++i;
+            ++j;
+        }
+    }
+
+    const unsigned kept = common + MIN(fp1->unknown_frames, fp2->unknown_frames);
+    return (float)(max_frames - kept) / max_frames;
+}
+
+static bool stat_core_backtrace(const char *dump_dir_name, struct timespec *mtime)
+{
+    char *bt_path = concat_path_file(dump_dir_name, FILENAME_CORE_BACKTRACE);
+    struct stat st;
+    const bool exists = lstat(bt_path, &st) == 0;
+    free(bt_path);
+
+    if (exists)
+        *mtime = st.st_mtim;
+    return exists;
+}
+
+/* Returns NULL if there is no fingerprint or if it was computed from
+ * a different core backtrace. */
+static struct crash_thread_fingerprint *load_fingerprint(const struct dump_dir *dd)
+{
+    const char *name = strrchr(dd->dd_dirname, '/');
+    const char *str = problem_info_cache_get_annotation(problem_info_cache,
+                            name != NULL ? name + 1 : dd->dd_dirname,
+                            CRASH_THREAD_FINGERPRINT_ANNOTATION);
+    if (str == NULL)
+        return NULL;
+
+    struct crash_thread_fingerprint *fp = fingerprint_parse(str);
+    if (fp == NULL)
+    {
+        log_notice("Ignoring malformed crash thread fingerprint of '%s'", dd->dd_dirname);
+        return NULL;
+    }
+
+    struct timespec bt_mtime;
+    if (!stat_core_backtrace(dd->dd_dirname, &bt_mtime)
+     || bt_mtime.tv_sec != fp->bt_mtime.tv_sec
+     || bt_mtime.tv_nsec != fp->bt_mtime.tv_nsec)
+    {
+        free(fp);
+        return NULL;
+    }
+
+    return fp;
+}
+
+static void save_fingerprint(const char *dump_dir_name)
+{
+    if (!stat_core_backtrace(dump_dir_name, &fingerprint->bt_mtime))
+        return;
+
+    const char *name = strrchr(dump_dir_name, '/');
+    char *str = fingerprint_to_str(fingerprint);
+    problem_info_cache_annotate(problem_info_cache, name != NULL ? name + 1 : dump_dir_name,
+                                CRASH_THREAD_FINGERPRINT_ANNOTATION, str);
+    free(str);
+}
+
 static int core_backtrace_is_duplicate(struct sr_stacktrace *bt1,
                                        const char *bt2_text)
 {
@@ -89,7 +301,11 @@ static int core_backtrace_is_duplicate(struct sr_stacktrace *bt1,
         goto end;
     }
 
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
     float distance = sr_distance(SR_DISTANCE_DAMERAU_LEVENSHTEIN, thread1, thread2);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    bt_distance_us += (end.tv_sec - start.tv_sec) * 1000000LL + (end.tv_nsec - start.tv_nsec) / 1000;
     log_info("Distance between backtraces: %f", distance);
     result = (distance <= BACKTRACE_DUP_THRESHOLD);
 
@@ -166,6 +382,12 @@ static void dup_corebt_init(const struct dump_dir *dd)
         log_notice("Failed to load core stacktrace: %s", error_message);
         free(error_message);
     }
+    else if (report_type == SR_REPORT_CORE)
+    {
+        struct sr_thread *thread = sr_stacktrace_find_crash_thread(corebt);
+        if (thread != NULL)
+            fingerprint = fingerprint_from_thread((struct sr_core_thread *)thread);
+    }
 
     free(corebt_text);
 }
@@ -177,6 +399,25 @@ static int dup_corebt_compare(const struct dump_dir *dd)
 
     int isdup;
 
+    ++bt_compared;
+    if (fingerprint != NULL)
+    {
+        struct crash_thread_fingerprint *dd_fingerprint = load_fingerprint(dd);
+        if (dd_fingerprint != NULL)
+        {
+            const float lower_bound = fingerprint_distance_lower_bound(fingerprint, dd_fingerprint);
+            free(dd_fingerprint);
+
+            /* A margin for rounding, the bound can be equal to the distance */
+            if (lower_bound > BACKTRACE_DUP_THRESHOLD + 0.0001)
+            {
+                log_debug("Distance between backtraces is at least %f", lower_bound);
+                ++bt_pruned;
+                return 0;
+            }
+        }
+    }
+
     char *dd_corebt = load_backtrace(dd);
     if (!dd_corebt)
         return 0;
@@ -194,6 +435,40 @@ static void dup_corebt_fini(void)
 {
     sr_stacktrace_free(corebt);
     corebt = NULL;
+    free(fingerprint);
+    fingerprint = NULL;
+}
+
+/* Returns false if the elements cached by abrtd prove that the problem is not
+ * a duplicate, so the problem directory does not need to be opened.
+ */
+static bool cached_problem_may_be_dup(const problem_info_t *pi)
+{
+    const char *value;
+
+    /* crashes of different users, different crash types and different
+     * executables are not duplicates */
+    problem_info_get_item(pi, FILENAME_UID, &value);
+    if (g_strcmp0(uid, value) != 0)
+        return false;
+
+    problem_info_get_item(pi, FILENAME_TYPE, &value);
+    if (g_strcmp0(type, value) != 0)
+        return false;
+
+    problem_info_get_item(pi, FILENAME_EXECUTABLE, &value);
+    if (g_strcmp0(executable, value) != 0)
+        return false;
+
+    /* UUID is compared only if there is no core backtrace, see
+     * dup_uuid_compare() */
+    if (corebt == NULL)
+    {
+        problem_info_get_item(pi, FILENAME_UUID, &value);
+        return g_strcmp0(uuid, value) == 0;
+    }
+
+    return true;
 }
 
 /* This function is run after each post-create event is finished (there may be
@@ -217,6 +492,10 @@ static void dup_corebt_fini(void)
  * If duplicate is not found as described above, the function returns 0 and we
  * either process remaining events if there are any, or successfully terminate
  * processing of the current dump directory.
+ *
+ * Only problem directories not cached in abrtd's problem info cache and
+ * cached problems with the same uid, type, executable (and UUID if there is no
+ * core backtrace) are opened.
  */
 static int is_crash_a_dup(const char *dump_dir_name, void *param)
 {
@@ -233,6 +512,10 @@ static int is_crash_a_dup(const char *dump_dir_name, void *param)
     dup_corebt_init(dd);
     dd_close(dd);
 
+    /* Nothing to compare */
+    if (uuid == NULL && corebt == NULL)
+        return 0;
+
     /* dump_dir_name can be relative */
     dump_dir_name = realpath(dump_dir_name, NULL);
 
@@ -240,8 +523,17 @@ static int is_crash_a_dup(const char *dump_dir_name, void *param)
     if (dir == NULL)
         goto end;
 
+    if (problem_info_cache == NULL)
+        problem_info_cache = problem_info_cache_new(g_settings_dump_location);
+
+    unsigned opened = 0;
+    unsigned filtered = 0;
+
     /* Scan crash dumps looking for a dup */
-    //TODO: explain why this is safe wrt concurrent runs
+    /* abrtd never runs post-create of two problems with the same uid, type
+     * and executable at the same time, so a possible duplicate can't be
+     * processed concurrently with this run.
+     */
     struct dirent *dent;
     while ((dent = readdir(dir)) != NULL && crash_dump_dup_name == NULL)
     {
@@ -251,6 +543,13 @@ static int is_crash_a_dup(const char *dump_dir_name, void *param)
         if (ext && strcmp(ext, ".new") == 0)
             continue; /* skip anything named "<dirname>.new" */
 
+        const problem_info_t *pi = problem_info_cache_lookup(problem_info_cache, dent->d_name);
+        if (pi != NULL && !cached_problem_may_be_dup(pi))
+        {
+            ++filtered;
+            continue;
+        }
+
         dd = NULL;
 
         char *tmp_concat_path = concat_path_file(g_settings_dump_location, dent->d_name);
@@ -278,6 +577,8 @@ static int is_crash_a_dup(const char *dump_dir_name, void *param)
         if (!dd)
             goto next;
 
+        ++opened;
+
         /* crashes of different users are not considered duplicates */
         dd_uid = dd_load_text_ext(dd, FILENAME_UID, DD_FAIL_QUIETLY_ENOENT);
         if (strcmp(uid, dd_uid))
@@ -319,6 +620,14 @@ next:
     }
     closedir(dir);
 
+    log_info("Opened %u problem directories, %u filtered out by the problem info cache", opened, filtered);
+    log_notice("Compared %u core backtraces, %u pruned by crash thread fingerprints, %llu us spent in distance computation",
+             bt_compared, bt_pruned, bt_distance_us);
+
+    /* Let next problems compare their backtraces with this one cheaply */
+    if (retval == 0 && fingerprint != NULL && dump_dir_name != NULL)
+        save_fingerprint(dump_dir_name);
+
 end:
     free((char*)dump_dir_name);
     return retval;
@@ -444,6 +753,8 @@ int main(int argc, char **argv)
         dump_dir_name = NULL;
     }
 
+    problem_info_cache_free(problem_info_cache);
+
     /* exit 0 means, that there is no duplicate of dump-dir */
     return 0;
 }
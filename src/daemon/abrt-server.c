@@ -18,6 +18,7 @@
 #include "problem_api.h"
 #include "abrt_glib.h"
 #include "libabrt.h"
+#include "abrt-server.h"
 
 /* Maximal length of backtrace. */
 #define MAX_BACKTRACE_SIZE (1024*1024)
@@ -25,8 +26,13 @@
 #define MAX_MESSAGE_SIZE (4*MAX_BACKTRACE_SIZE)
 /* Maximal number of characters read from socket at once. */
 #define INPUT_BUFFER_SIZE (8*1024)
+/* Maximal length of a value kept in memory, see element_is_inline() */
+#define MAX_INLINE_VALUE_SIZE (64*1024)
 /* We exit after this many seconds */
 #define TIMEOUT 10
+/* A worker exits after this many clients to get rid of any accumulated state,
+ * abrtd starts a new one */
+#define WORKER_MAX_CLIENTS 256
 
 #define ABRT_SERVER_EVENT_ENV "ABRT_SERVER_PID"
 
@@ -92,6 +98,10 @@ static unsigned total_bytes_read = 0;
 
 static pid_t client_pid = (pid_t)-1L;
 static uid_t client_uid = (uid_t)-1L;
+/* The client got its response before post-create */
+static bool client_response_sent = false;
+/* Serving clients passed by abrtd instead of exiting after one client */
+static bool worker_mode = false;
 
 static void
 handle_signal(int signo)
@@ -365,6 +375,8 @@ static int run_post_create(const char *dirname, struct response *resp)
     g_io_channel_unref(channel_signal);
     close(g_signal_pipe[1]);
     close(g_signal_pipe[0]);
+    signal(SIGUSR1, SIG_DFL);
+    signal(SIGINT, SIG_DFL);
 
     log_notice("Waiting finished");
 
@@ -564,11 +576,321 @@ static int run_post_create(const char *dirname, struct response *resp)
     return 0;
 }
 
+/* Checks the key, it has to be valid filename and will end up in the
+ * bugzilla */
+static gboolean key_ok(const gchar *key)
+{
+    for (const gchar *i = key; *i != 0; i++)
+    {
+        if (!isalpha(*i) && (*i != '-') && (*i != '_') && (*i != ' '))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean key_value_ok(gchar *key, gchar *value)
+{
+    if (!key_ok(key))
+        return FALSE;
+
+    /* check value of 'basename', it has to be valid non-hidden directory
+     * name */
+    if (strcmp(key, "basename") == 0
+     || strcmp(key, FILENAME_TYPE) == 0
+    )
+    {
+        if (!str_is_correct_filename(value))
+        {
+            error_msg("Value of '%s' ('%s') is not a valid directory name",
+                      key, value);
+            return FALSE;
+        }
+    }
+
+    return allowed_new_user_problem_entry(client_uid, key, value);
+}
+
+/* Values of these elements are needed before the problem directory is
+ * created or must be checked as a whole, hence they are kept in memory.
+ * Values of all other elements are written to a staging directory as they
+ * arrive.
+ */
+static bool element_is_inline(const char *key)
+{
+    return strcmp(key, "basename") == 0
+        || strcmp(key, FILENAME_TYPE) == 0
+        || strcmp(key, FILENAME_ANALYZER) == 0
+        || strcmp(key, FILENAME_PID) == 0
+        || strcmp(key, FILENAME_EXECUTABLE) == 0;
+}
+
+/* Elements streamed from the client wait in this directory until the problem
+ * directory is created. The directory is deleted when abrt-server dies.
+ */
+static struct dump_dir *staging_dd;
+static unsigned staging_dir_count;
+
+static void delete_staging_dir(void)
+{
+    if (staging_dd)
+    {
+        dd_delete(staging_dd);
+        staging_dd = NULL;
+    }
+}
+
+static void create_staging_dir(void)
+{
+    if (staging_dd)
+        return;
+
+    /* Exit if free space is less than 1/4 of MaxCrashReportsSize */
+    if (g_settings_nMaxCrashReportsSize > 0)
+    {
+        if (low_free_space(g_settings_nMaxCrashReportsSize, g_settings_dump_location))
+            exit(1);
+    }
+
+    char *path = xasprintf("%s/abrt-server-%lu-%u.new",
+                           g_settings_dump_location,
+                           (long)getpid(),
+                           ++staging_dir_count);
+
+    staging_dd = dd_create(path, /*fs owner*/0, DEFAULT_DUMP_DIR_MODE);
+    if (!staging_dd)
+        error_msg_and_die("Error creating problem directory '%s'", path);
+
+    free(path);
+}
+
+/* Parses the body of a creation request: a sequence of NUL terminated
+ * KEY=value messages. The body is parsed in chunks as they are read from the
+ * socket, so a message may span any number of chunks.
+ */
+struct body_parser
+{
+    enum {
+        BP_KEY,          /* reading the key */
+        BP_INLINE_VALUE, /* reading the value into memory */
+        BP_STREAM_VALUE, /* writing the value to the staging directory */
+        BP_SKIP_VALUE,   /* ignoring the rest of an invalid message */
+    } state;
+    struct strbuf *key;
+    struct strbuf *value;
+    /* Lower case key of the message whose value is being read */
+    char *name;
+    int stream_fd;
+    /* Elements kept in memory */
+    GHashTable *problem_info;
+    /* Names of elements written to the staging directory */
+    GHashTable *streamed;
+};
+
+static void body_parser_init(struct body_parser *bp, GHashTable *problem_info)
+{
+    bp->state = BP_KEY;
+    bp->key = strbuf_new();
+    bp->value = strbuf_new();
+    bp->name = NULL;
+    bp->stream_fd = -1;
+    bp->problem_info = problem_info;
+    bp->streamed = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+}
+
+static void body_parser_destroy(struct body_parser *bp)
+{
+    if (bp->stream_fd >= 0)
+        close(bp->stream_fd);
+    free(bp->name);
+    strbuf_free(bp->value);
+    strbuf_free(bp->key);
+    g_hash_table_destroy(bp->streamed);
+}
+
+/* Called when the '=' of a message is seen */
+static void body_parser_start_value(struct body_parser *bp)
+{
+    bp->state = BP_SKIP_VALUE;
+
+    free(bp->name);
+    bp->name = xstrdup(bp->key->buf);
+    for (char *c = bp->name; *c; ++c)
+        *c = g_ascii_tolower(*c);
+
+    if (!key_ok(bp->name))
+    {
+        /* should use error_msg_and_die() here? */
+        error_msg("Invalid key format: %s", bp->key->buf);
+        return;
+    }
+
+    if (strcmp(bp->name, FILENAME_UID) == 0)
+    {
+        error_msg("Ignoring value of %s, will be determined later",
+                  FILENAME_UID);
+        return;
+    }
+
+    if (element_is_inline(bp->name))
+    {
+        strbuf_clear(bp->value);
+        bp->state = BP_INLINE_VALUE;
+        return;
+    }
+
+    create_staging_dir();
+
+    /* A repeated element replaces the previous value */
+    bp->stream_fd = dd_open_item(staging_dd, bp->name, O_RDWR);
+    if (bp->stream_fd < 0)
+    {
+        error_msg("Can't save element '%s'", bp->name);
+        return;
+    }
+
+    if (ftruncate(bp->stream_fd, 0) != 0)
+    {
+        perror_msg("Can't truncate element '%s'", bp->name);
+        close(bp->stream_fd);
+        bp->stream_fd = -1;
+        return;
+    }
+
+    bp->state = BP_STREAM_VALUE;
+}
+
+/* Called when the NUL terminating a value is seen */
+static void body_parser_finish_value(struct body_parser *bp)
+{
+    if (bp->state == BP_INLINE_VALUE)
+    {
+        if (key_value_ok(bp->name, bp->value->buf))
+        {
+            g_hash_table_insert(bp->problem_info, bp->name, xstrdup(bp->value->buf));
+            /* Prevent freeing name later: */
+            bp->name = NULL;
+        }
+        else
+        {
+            /* should use error_msg_and_die() here? */
+            error_msg("Invalid key or value format: %s=%s", bp->key->buf, bp->value->buf);
+        }
+    }
+    else if (bp->state == BP_STREAM_VALUE)
+    {
+        close(bp->stream_fd);
+        bp->stream_fd = -1;
+        g_hash_table_add(bp->streamed, xstrdup(bp->name));
+    }
+
+    strbuf_clear(bp->key);
+    bp->state = BP_KEY;
+}
+
+static void body_parser_feed(struct body_parser *bp, const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        const char *nul = memchr(data, '\0', len);
+        size_t chunk = nul ? (size_t)(nul - data) : len;
+
+        if (bp->state == BP_KEY)
+        {
+            const char *eq = memchr(data, '=', chunk);
+            if (eq)
+                chunk = eq - data;
+
+            /* Keys are file names, longer keys are invalid anyway */
+            if (bp->key->len + chunk > PATH_MAX)
+                error_msg_and_die("Key is too long, aborting");
+
+            strbuf_append_strf(bp->key, "%.*s", (int)chunk, data);
+
+            if (eq)
+                body_parser_start_value(bp);
+            else if (nul)
+            {
+                /* should use error_msg_and_die() here? */
+                error_msg("Invalid message format: '%s'", bp->key->buf);
+                strbuf_clear(bp->key);
+            }
+            else
+                return;
+
+            /* Skip '=' or NUL */
+            ++chunk;
+        }
+        else
+        {
+            if (bp->state == BP_INLINE_VALUE)
+            {
+                if (bp->value->len + chunk > MAX_INLINE_VALUE_SIZE)
+                    error_msg_and_die("Value of '%s' is too long, aborting", bp->name);
+
+                strbuf_append_strf(bp->value, "%.*s", (int)chunk, data);
+            }
+            else if (bp->state == BP_STREAM_VALUE)
+            {
+                if (full_write(bp->stream_fd, data, chunk) != chunk)
+                    perror_msg_and_die("Can't save element '%s'", bp->name);
+            }
+
+            if (!nul)
+                return;
+
+            body_parser_finish_value(bp);
+            ++chunk;
+        }
+
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+/* Called at EOF, an unterminated message is ignored */
+static void body_parser_finish(struct body_parser *bp)
+{
+    if (bp->state == BP_STREAM_VALUE)
+    {
+        close(bp->stream_fd);
+        bp->stream_fd = -1;
+        dd_delete_item(staging_dd, bp->name);
+    }
+
+    bp->state = BP_KEY;
+}
+
+/* Moves the elements from the staging directory to the problem directory.
+ * Both directories are owned by the same user, hence the files have correct
+ * ownership and permissions. */
+static void move_staged_elements(struct dump_dir *dd, GHashTable *streamed)
+{
+    GHashTableIter iter;
+    gpointer name;
+    g_hash_table_iter_init(&iter, streamed);
+    while (g_hash_table_iter_next(&iter, &name, NULL))
+    {
+        char *src = concat_path_file(staging_dd->dd_dirname, name);
+        char *dst = concat_path_file(dd->dd_dirname, name);
+        if (rename(src, dst) != 0)
+            perror_msg("Can't move '%s' to '%s'", src, dst);
+        free(dst);
+        free(src);
+    }
+}
+
 /* Create a new problem directory from client session.
  * Caller must ensure that all fields in struct client
  * are properly filled.
+ *
+ * Elements received in memory are in problem_info, the streamed elements are
+ * moved from the staging directory.
+ *
+ * Sends the response to the client before running post-create and does not
+ * return unless running in the worker mode.
  */
-static int create_problem_dir(GHashTable *problem_info, unsigned pid)
+static int create_problem_dir(GHashTable *problem_info, GHashTable *streamed, unsigned pid)
 {
     /* Exit if free space is less than 1/4 of MaxCrashReportsSize */
     if (g_settings_nMaxCrashReportsSize > 0)
@@ -719,6 +1041,12 @@ static int create_problem_dir(GHashTable *problem_info, unsigned pid)
         dd_save_text(dd, (gchar *) gpkey, (gchar *) gpvalue);
     }
 
+    if (staging_dd)
+    {
+        move_staged_elements(dd, streamed);
+        delete_staging_dir();
+    }
+
     dd_save_text(dd, FILENAME_ABRT_VERSION, VERSION);
 
     dd_close(dd);
@@ -741,6 +1069,7 @@ static int create_problem_dir(GHashTable *problem_info, unsigned pid)
      */
     printf("HTTP/1.1 201 Created\r\n\r\n");
     fflush(NULL);
+    client_response_sent = true;
 
     /* Closing STDIN_FILENO (abrtd duped the socket to stdin and stdout) and
      * not-replacing it with something else to let abrt-server die on reading
@@ -757,80 +1086,14 @@ static int create_problem_dir(GHashTable *problem_info, unsigned pid)
 
     run_post_create(path, NULL);
 
-    /* free(path); */
-    exit(0);
-}
-
-static gboolean key_value_ok(gchar *key, gchar *value)
-{
-    char *i;
-
-    /* check key, it has to be valid filename and will end up in the
-     * bugzilla */
-    for (i = key; *i != 0; i++)
-    {
-        if (!isalpha(*i) && (*i != '-') && (*i != '_') && (*i != ' '))
-            return FALSE;
-    }
+    if (!worker_mode)
+        exit(0);
 
-    /* check value of 'basename', it has to be valid non-hidden directory
-     * name */
-    if (strcmp(key, "basename") == 0
-     || strcmp(key, FILENAME_TYPE) == 0
-    )
-    {
-        if (!str_is_correct_filename(value))
-        {
-            error_msg("Value of '%s' ('%s') is not a valid directory name",
-                      key, value);
-            return FALSE;
-        }
-    }
-
-    return allowed_new_user_problem_entry(client_uid, key, value);
+    free(path);
+    return 201;
 }
 
-/* Handles a message received from client over socket. */
-static void process_message(GHashTable *problem_info, char *message)
-{
-    gchar *key, *value;
-
-    value = strchr(message, '=');
-    if (value)
-    {
-        key = g_ascii_strdown(message, value - message); /* result is malloced */
-//TODO: is it ok? it uses g_malloc, not malloc!
-
-        value++;
-        if (key_value_ok(key, value))
-        {
-            if (strcmp(key, FILENAME_UID) == 0)
-            {
-                error_msg("Ignoring value of %s, will be determined later",
-                          FILENAME_UID);
-            }
-            else
-            {
-                g_hash_table_insert(problem_info, key, xstrdup(value));
-                /* Prevent freeing key later: */
-                key = NULL;
-            }
-        }
-        else
-        {
-            /* should use error_msg_and_die() here? */
-            error_msg("Invalid key or value format: %s", message);
-        }
-        free(key);
-    }
-    else
-    {
-        /* should use error_msg_and_die() here? */
-        error_msg("Invalid message format: '%s'", message);
-    }
-}
-
-static void die_if_data_is_missing(GHashTable *problem_info)
+static void die_if_data_is_missing(GHashTable *problem_info, GHashTable *streamed)
 {
     gboolean missing_data = FALSE;
     gchar **pstring;
@@ -844,7 +1107,8 @@ static void die_if_data_is_missing(GHashTable *problem_info)
 
     for (pstring = (gchar**) needed; *pstring; pstring++)
     {
-        if (!g_hash_table_lookup(problem_info, *pstring))
+        if (!g_hash_table_lookup(problem_info, *pstring)
+         && !g_hash_table_contains(streamed, *pstring))
         {
             error_msg("Element '%s' is missing", *pstring);
             missing_data = TRUE;
@@ -988,27 +1252,25 @@ static int perform_http_xact(struct response *rsp)
 
     messagebuf_len -= (body_start - messagebuf_data);
     memmove(messagebuf_data, body_start, messagebuf_len);
-    log_debug("Body so far: %u bytes, '%s'", messagebuf_len, messagebuf_data);
+    log_debug("Body so far: %u bytes", messagebuf_len);
+
+    /* The body of a creation request is parsed as it is being received and
+     * large values are written to files immediately. The body of a creation
+     * notification is a short directory name.
+     */
+    struct body_parser parser;
+    body_parser_init(&parser, problem_info);
+    if (url_type == CREATION_REQUEST)
+    {
+        body_parser_feed(&parser, messagebuf_data, messagebuf_len);
+        messagebuf_len = 0;
+    }
 
     /* Loop until EOF/error/timeout */
+    char buf[INPUT_BUFFER_SIZE];
     while (1)
     {
-        if (url_type == CREATION_REQUEST)
-        {
-            while (1)
-            {
-                unsigned len = strnlen(messagebuf_data, messagebuf_len);
-                if (len >= messagebuf_len)
-                    break;
-                /* messagebuf has at least one NUL - process the line */
-                process_message(problem_info, messagebuf_data);
-                messagebuf_len -= (len + 1);
-                memmove(messagebuf_data, messagebuf_data + len + 1, messagebuf_len);
-            }
-        }
-
-        messagebuf_data = xrealloc(messagebuf_data, messagebuf_len + INPUT_BUFFER_SIZE + 1);
-        int rd = read(STDIN_FILENO, messagebuf_data + messagebuf_len, INPUT_BUFFER_SIZE);
+        int rd = read(STDIN_FILENO, buf, sizeof(buf));
         if (rd < 0)
         {
             if (errno == EINTR) /* SIGALRM? */
@@ -1019,15 +1281,25 @@ static int perform_http_xact(struct response *rsp)
             break;
 
         log_debug("Received %u bytes of data", rd);
-        messagebuf_len += rd;
         total_bytes_read += rd;
         if (total_bytes_read > MAX_MESSAGE_SIZE)
             error_msg_and_die("Message is too long, aborting");
+
+        if (url_type == CREATION_REQUEST)
+            body_parser_feed(&parser, buf, rd);
+        else
+        {
+            messagebuf_data = xrealloc(messagebuf_data, messagebuf_len + rd + 1);
+            memcpy(messagebuf_data + messagebuf_len, buf, rd);
+            messagebuf_len += rd;
+        }
     }
 
     /* Body received, EOF was seen. Don't let alarm to interrupt after this. */
     alarm(0);
 
+    body_parser_finish(&parser);
+
     int ret = 0;
     if (url_type == CREATION_NOTIFICATION)
     {
@@ -1038,11 +1310,12 @@ static int perform_http_xact(struct response *rsp)
             goto out;
         }
 
+        body_parser_destroy(&parser);
         messagebuf_data[messagebuf_len] = '\0';
         return run_post_create(messagebuf_data, rsp);
     }
 
-    die_if_data_is_missing(problem_info);
+    die_if_data_is_missing(problem_info, parser.streamed);
 
     /* Save problem dir */
     char *executable = g_hash_table_lookup(problem_info, FILENAME_EXECUTABLE);
@@ -1075,16 +1348,147 @@ static int perform_http_xact(struct response *rsp)
         pid = client_pid;
     }
 
-    create_problem_dir(problem_info, pid);
-    /* does not return */
+    /* problem_info is destroyed by create_problem_dir() */
+    ret = create_problem_dir(problem_info, parser.streamed, pid);
+    /* does not return unless in the worker mode */
+    body_parser_destroy(&parser);
+    return ret;
 
  out:
+    /* Drop the elements received from the client */
+    delete_staging_dir();
+    body_parser_destroy(&parser);
     g_hash_table_destroy(problem_info);
     return ret; /* Used as HTTP response code */
 }
 
 static void dummy_handler(int sig_unused) {}
 
+/* Handles one client connected to STDIN_FILENO and STDOUT_FILENO */
+static int serve_client(void)
+{
+    /* Set the timeout per se, see SIGALRM handler in main() */
+    alarm(TIMEOUT);
+
+    /* Get uid of the connected client */
+    struct ucred cr;
+    socklen_t crlen = sizeof(cr);
+    if (0 != getsockopt(STDIN_FILENO, SOL_SOCKET, SO_PEERCRED, &cr, &crlen))
+        perror_msg_and_die("getsockopt(SO_PEERCRED)");
+    if (crlen != sizeof(cr))
+        error_msg_and_die("%s: bad crlen %d", "getsockopt(SO_PEERCRED)", (int)crlen);
+
+    if (client_uid == (uid_t)-1L)
+        client_uid = cr.uid;
+
+    client_pid = cr.pid;
+
+    struct response rsp = { 0 };
+    int r = perform_http_xact(&rsp);
+    alarm(0);
+    if (r == 0)
+        r = 200;
+
+    if (rsp.code == 0)
+        rsp.code = r;
+
+    if (!client_response_sent)
+    {
+        printf("HTTP/1.1 %u \r\n\r\n", rsp.code);
+        if (rsp.message != NULL)
+            printf("%s", rsp.message);
+        fflush(stdout);
+    }
+    free(rsp.message);
+
+    return r;
+}
+
+/* Receives a client connection passed by abrtd via SCM_RIGHTS. Returns -1 if
+ * abrtd closed the control socket. */
+static int receive_client_fd(int control_fd)
+{
+    char byte;
+    struct iovec iov = { .iov_base = &byte, .iov_len = sizeof(byte) };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf),
+    };
+
+    ssize_t r;
+    do
+        r = recvmsg(control_fd, &msg, MSG_CMSG_CLOEXEC);
+    while (r < 0 && errno == EINTR);
+
+    if (r < 0)
+        perror_msg_and_die("recvmsg");
+    if (r == 0)
+        return -1;
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == NULL
+     || cmsg->cmsg_level != SOL_SOCKET
+     || cmsg->cmsg_type != SCM_RIGHTS
+     || cmsg->cmsg_len != CMSG_LEN(sizeof(int)))
+        error_msg_and_die("No client descriptor received from abrtd");
+
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+    return fd;
+}
+
+/* Serves clients whose connections abrtd passes over the control socket on
+ * STDIN_FILENO. The configuration is re-read only if abrt.conf changes.
+ */
+static int serve_clients(void)
+{
+    const int control_fd = xdup(STDIN_FILENO);
+    close_on_exec_on(control_fd);
+    xmove_fd(xopen("/dev/null", O_RDWR), STDIN_FILENO);
+
+    const uid_t opt_client_uid = client_uid;
+    for (unsigned served = 0; served < WORKER_MAX_CLIENTS; ++served)
+    {
+        const int client_fd = receive_client_fd(control_fd);
+        if (client_fd < 0)
+        {
+            log_debug("abrtd closed the control socket");
+            break;
+        }
+
+        xdup2(client_fd, STDIN_FILENO);
+        xdup2(client_fd, STDOUT_FILENO);
+        close(client_fd);
+
+        client_uid = opt_client_uid;
+        client_pid = (pid_t)-1L;
+        client_response_sent = false;
+        total_bytes_read = 0;
+
+        load_abrt_conf_if_changed();
+        serve_client();
+
+        /* Disconnect the client, if create_problem_dir() has not done it */
+        xmove_fd(xopen("/dev/null", O_RDWR), STDIN_FILENO);
+        xdup2(STDERR_FILENO, STDOUT_FILENO);
+
+        /* abrtd must not pass any client to a process which is about to exit,
+         * the client would be lost */
+        const bool last = served + 1 == WORKER_MAX_CLIENTS;
+        fprintf(stderr, "%s\n", last ? ABRT_SERVER_RETIRING : ABRT_SERVER_CLIENT_DONE);
+        fflush(stderr);
+    }
+
+    close(control_fd);
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     /* I18n */
@@ -1105,6 +1509,7 @@ int main(int argc, char **argv)
         OPT_u = 1 << 1,
         OPT_s = 1 << 2,
         OPT_p = 1 << 3,
+        OPT_w = 1 << 4,
     };
     /* Keep enum above and order of options below in sync! */
     struct options program_options[] = {
@@ -1112,6 +1517,7 @@ int main(int argc, char **argv)
         OPT_INTEGER('u', NULL, &client_uid, _("Use NUM as client uid")),
         OPT_BOOL(   's', NULL, NULL       , _("Log to syslog")),
         OPT_BOOL(   'p', NULL, NULL       , _("Add program names to log")),
+        OPT_BOOL(   'w', NULL, NULL       , _("Serve clients passed by abrtd over STDIN")),
         OPT_END()
     };
     unsigned opts = parse_opts(argc, argv, program_options, program_usage_string);
@@ -1133,45 +1539,26 @@ int main(int argc, char **argv)
     memset(&sa, 0, sizeof(sa));
     sa.sa_handler = dummy_handler; /* pity, SIG_DFL won't do */
     sigaction(SIGALRM, &sa, NULL);
-    /* Part 2 - set the timeout per se */
-    alarm(TIMEOUT);
-
-    /* Get uid of the connected client */
-    struct ucred cr;
-    socklen_t crlen = sizeof(cr);
-    if (0 != getsockopt(STDIN_FILENO, SOL_SOCKET, SO_PEERCRED, &cr, &crlen))
-        perror_msg_and_die("getsockopt(SO_PEERCRED)");
-    if (crlen != sizeof(cr))
-        error_msg_and_die("%s: bad crlen %d", "getsockopt(SO_PEERCRED)", (int)crlen);
+    /* Part 2 - the timeout is set per client in serve_client() */
 
-    if (client_uid == (uid_t)-1L)
-        client_uid = cr.uid;
-
-    client_pid = cr.pid;
+    /* Don't leave streamed elements behind if abrt-server dies */
+    atexit(delete_staging_dir);
 
     pid_t pid = getpid();
     if (get_ns_ids(getpid(), &g_ns_ids) < 0)
         error_msg_and_die("Cannot get own Namespaces from /proc/%d/ns", pid);
 
-    load_abrt_conf();
+    if (opts & OPT_w)
+    {
+        worker_mode = true;
+        return serve_clients();
+    }
 
-    struct response rsp = { 0 };
-    int r = perform_http_xact(&rsp);
-    if (r == 0)
-        r = 200;
+    load_abrt_conf();
 
-    if (rsp.code == 0)
-        rsp.code = r;
+    int r = serve_client();
 
     free_abrt_conf_data();
 
-    printf("HTTP/1.1 %u \r\n\r\n", rsp.code);
-    if (rsp.message != NULL)
-    {
-        printf("%s", rsp.message);
-        fflush(stdout);
-        free(rsp.message);
-    }
-
     return (r >= 400); /* Error if 400+ */
 }
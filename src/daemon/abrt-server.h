@@ -0,0 +1,31 @@
+/*
+    Copyright (C) 2016  ABRT Team
+    Copyright (C) 2016  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef _ABRT_SERVER_H_
+#define _ABRT_SERVER_H_
+
+/* Lines a resident abrt-server writes to abrtd after it has served a client */
+
+/* The process is ready for the next client */
+#define ABRT_SERVER_CLIENT_DONE "CLIENT_DONE"
+/* The process has served its last client and exits, no more clients must be
+ * passed to it */
+#define ABRT_SERVER_RETIRING "RETIRING"
+
+#endif /*_ABRT_SERVER_H_*/
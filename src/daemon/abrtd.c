@@ -24,6 +24,7 @@
 
 #include "abrt_glib.h"
 #include "abrt-inotify.h"
+#include "abrt-server.h"
 #include "libabrt.h"
 #include "problem_api.h"
 
@@ -41,11 +42,20 @@
 #define SOCKET_PERMISSION 0666
 /* Maximum number of simultaneously opened client connections. */
 #define MAX_CLIENT_COUNT  10
+/* Number of resident abrt-server processes serving clients one after another.
+ * A new abrt-server process is started for a client only if all of them are
+ * busy. */
+#define ABRT_SERVER_POOL_SIZE 4
 
 #define IN_DUMP_LOCATION_FLAGS (IN_DELETE_SELF | IN_MOVE_SELF)
 
 #define ABRTD_DBUS_NAME ABRT_DBUS_NAME".daemon"
 
+/* Delay of problem info cache update after a problem has been processed.
+ * Elements modified in the last two seconds are not cached.
+ */
+#define PROBLEM_INFO_SYNC_DELAY 3
+
 /* Daemon initializes, then sits in glib main loop, waiting for events.
  * Events can be:
  * - inotify: something new appeared under /var/tmp/abrt or /var/spool/abrt-upload
@@ -61,16 +71,27 @@ static GMainLoop *s_main_loop;
 
 GList *s_processes;
 GList *s_dir_queue;
+/* Dedup keys of problems being processed by post-create -> abrt_server_proc */
+static GHashTable *s_post_create_keys;
 
 static GIOChannel *channel_socket = NULL;
 static guint channel_id_socket = 0;
 static int child_count = 0;
 
+static problem_info_cache_t *s_problem_info_cache;
+static guint s_problem_info_sync_src;
+
 struct abrt_server_proc
 {
     pid_t pid;
     int fdout;
     char *dirname;
+    char *dedup_key;
+    /* abrtd's end of the socket passing clients to a resident abrt-server,
+     * -1 if the process serves only one client */
+    int control_fd;
+    bool idle;
+    bool served;
     GIOChannel *channel;
     guint watch_id;
     enum {
@@ -115,7 +136,10 @@ static void stop_abrt_server(struct abrt_server_proc *proc)
 static void dispose_abrt_server(struct abrt_server_proc *proc)
 {
     close(proc->fdout);
+    if (proc->control_fd >= 0)
+        close(proc->control_fd);
     free(proc->dirname);
+    free(proc->dedup_key);
 
     if (proc->watch_id > 0)
         g_source_remove(proc->watch_id);
@@ -124,40 +148,174 @@ static void dispose_abrt_server(struct abrt_server_proc *proc)
         g_io_channel_unref(proc->channel);
 }
 
+static gboolean sync_problem_info_cache_cb(gpointer unused)
+{
+    s_problem_info_sync_src = 0;
+
+    log_debug("Updating problem info cache");
+    const int r = problem_info_cache_sync(s_problem_info_cache);
+    if (r != 0)
+        log_info("Failed to update problem info cache: %s", strerror(-r));
+
+    return FALSE; /* Remove this event */
+}
+
+/* Problems are created and deleted in batches, so the cache is updated once
+ * for all of them.
+ */
+static void schedule_problem_info_cache_sync(void)
+{
+    if (s_problem_info_cache == NULL || s_problem_info_sync_src != 0)
+        return;
+
+    s_problem_info_sync_src = g_timeout_add_seconds(PROBLEM_INFO_SYNC_DELAY,
+                                                    sync_problem_info_cache_cb, NULL);
+}
+
+static unsigned get_max_post_create_processes(void)
+{
+    if (g_settings_nMaxPostCreateProcesses != 0)
+        return g_settings_nMaxPostCreateProcesses;
+
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? cpus : 1;
+}
+
+/* Processes waiting for post-create are clients too, hence they must not
+ * prevent the running ones from being accepted.
+ */
+static unsigned get_max_client_count(void)
+{
+    return MAX_CLIENT_COUNT + ABRT_SERVER_POOL_SIZE + get_max_post_create_processes();
+}
+
+/* post-create checks whether the new problem is a duplicate of another
+ * problem and problems are duplicates only if they have the same uid, type
+ * and executable (see is_crash_a_dup() in abrt-handle-event.c). Hence
+ * problems with different keys can be processed concurrently.
+ *
+ * The files are read directly because the main loop must not wait for a dump
+ * directory lock. A missing file is an empty string, is_crash_a_dup() sees
+ * the same files.
+ */
+static char *load_dedup_key(const char *dirname)
+{
+    static const char *const key_elements[] = {
+        FILENAME_UID,
+        FILENAME_TYPE,
+        FILENAME_EXECUTABLE,
+    };
+
+    struct strbuf *key = strbuf_new();
+    for (size_t i = 0; i < ARRAY_SIZE(key_elements); ++i)
+    {
+        char *path = concat_path_file(dirname, key_elements[i]);
+        size_t max_size = PATH_MAX;
+        char *value = xmalloc_open_read_close(path, &max_size);
+        free(path);
+
+        /* Values are separated by new lines, uid and type can't contain them */
+        if (i != 0)
+            strbuf_append_char(key, '\n');
+        if (value != NULL)
+            strbuf_append_str(key, value);
+        free(value);
+    }
+
+    return strbuf_free_nobuf(key);
+}
+
+/* Releases the dedup key held by the process, if any. */
+static void release_dedup_key(struct abrt_server_proc *proc)
+{
+    if (proc->dedup_key != NULL && g_hash_table_lookup(s_post_create_keys, proc->dedup_key) == proc)
+        g_hash_table_remove(s_post_create_keys, proc->dedup_key);
+}
+
+/* Lets process as many queued directories as allowed. The queue is processed
+ * in order and a directory is skipped only if a directory with the same dedup
+ * key is being processed, so directories with the same key are processed in
+ * the order they were detected.
+ */
 static void notify_next_post_create_process(struct abrt_server_proc *finished)
 {
     if (finished != NULL)
+    {
         s_dir_queue = g_list_remove(s_dir_queue, finished);
+        release_dedup_key(finished);
+    }
+
+    const unsigned max_running = get_max_post_create_processes();
 
-    while (s_dir_queue != NULL)
+    GList *li = s_dir_queue;
+    while (li != NULL && g_hash_table_size(s_post_create_keys) < max_running)
     {
-        struct abrt_server_proc *n = (struct abrt_server_proc *)s_dir_queue->data;
-        if (n->type == AS_POST_CREATE)
-            break;
+        GList *next = g_list_next(li);
+        struct abrt_server_proc *n = (struct abrt_server_proc *)li->data;
+        if (n->type == AS_POST_CREATE || g_hash_table_contains(s_post_create_keys, n->dedup_key))
+        {
+            li = next;
+            continue;
+        }
 
         if (kill(n->pid, SIGUSR1) >= 0)
         {
             n->type = AS_POST_CREATE;
-            break;
+            g_hash_table_insert(s_post_create_keys, n->dedup_key, n);
+            log_debug("abrt-server(%d): post-create started, %u running", n->pid,
+                      g_hash_table_size(s_post_create_keys));
+        }
+        else
+        {
+            /* This could happen only if the notified process disappeared - crashed?
+             */
+            perror_msg("Failed to send SIGUSR1 to %d", n->pid);
+            log_warning("Directory '%s' will not be processed", n->dirname);
+
+            /* Remove the problematic process from the post-crate directory queue
+             * and go to try to notify another process.
+             */
+            s_dir_queue = g_list_delete_link(s_dir_queue, li);
         }
 
-        /* This could happen only if the notified process disappeared - crashed?
-         */
-        perror_msg("Failed to send SIGUSR1 to %d", n->pid);
-        log_warning("Directory '%s' will not be processed", n->dirname);
+        li = next;
+    }
+}
 
-        /* Remove the problematic process from the post-crate directory queue
-         * and go to try to notify another process.
+/* Removes the process from the post-create queue and lets another one run. */
+static void dequeue_post_create_process(struct abrt_server_proc *proc)
+{
+    s_dir_queue = g_list_remove(s_dir_queue, proc);
+    release_dedup_key(proc);
+}
+
+/* Called when abrt-server finished handling of its client. */
+static void finish_abrt_server_client(struct abrt_server_proc *proc)
+{
+    if (proc->type == AS_POST_CREATE)
+    {
+        notify_next_post_create_process(proc);
+        schedule_problem_info_cache_sync();
+    }
+    else
+    {   /* Make sure out-of-order exited abrt-server post-create processes do
+         * not stay in the post-create queue.
          */
-        s_dir_queue = g_list_delete_link(s_dir_queue, s_dir_queue);
+        s_dir_queue = g_list_remove(s_dir_queue, proc);
     }
+
+    proc->type = AS_UKNOWN;
+    free(proc->dirname);
+    proc->dirname = NULL;
+    free(proc->dedup_key);
+    proc->dedup_key = NULL;
 }
 
 /* Queueing the process will also lead to cleaning up the dump location.
  */
 static void queue_post_craete_process(struct abrt_server_proc *proc)
 {
-    load_abrt_conf();
+    load_abrt_conf_if_changed();
     struct abrt_server_proc *running = s_dir_queue == NULL ? NULL
                                                            : (struct abrt_server_proc *)s_dir_queue->data;
     if (g_settings_nMaxCrashReportsSize == 0)
@@ -173,11 +331,13 @@ static void queue_post_craete_process(struct abrt_server_proc *proc)
         /* Move behind '/' */
         ++ignored;
 
-    char *worst_dir = NULL;
+    GList *worst_dirs = NULL;
     const double max_size = 1024 * 1024 * g_settings_nMaxCrashReportsSize;
-    while (get_dirsize_find_largest_dir(g_settings_dump_location, &worst_dir, ignored) >= max_size
-           && worst_dir)
+    double cur_size = get_dirsize_find_worst_dirs(g_settings_dump_location, &worst_dirs, ignored);
+    for (GList *li = worst_dirs; li != NULL && cur_size >= max_size; li = g_list_next(li))
     {
+        const struct dir_size *worst = (const struct dir_size *)li->data;
+        const char *worst_dir = worst->name;
         const char *kind = "old";
 
         GList *proc_of_deleted_item = NULL;
@@ -189,6 +349,10 @@ static void queue_post_craete_process(struct abrt_server_proc *proc)
         }
         else if ((proc_of_deleted_item = g_list_find_custom(s_dir_queue, worst_dir, (GCompareFunc)abrt_server_compare_dirname)))
         {
+            /* Never delete directories being processed */
+            if (((struct abrt_server_proc *)proc_of_deleted_item->data)->type == AS_POST_CREATE)
+                continue;
+
             kind = "unprocessed";
             struct abrt_server_proc *removed_proc = (struct abrt_server_proc *)proc_of_deleted_item->data;
             s_dir_queue = g_list_delete_link(s_dir_queue, proc_of_deleted_item);
@@ -200,29 +364,33 @@ static void queue_post_craete_process(struct abrt_server_proc *proc)
                 kind, worst_dir);
 
         char *deleted = concat_path_file(g_settings_dump_location, worst_dir);
-        free(worst_dir);
-        worst_dir = NULL;
 
         struct dump_dir *dd = dd_opendir(deleted, DD_FAIL_QUIETLY_ENOENT);
         if (dd != NULL)
             dd_delete(dd);
 
         free(deleted);
+        schedule_problem_info_cache_sync();
+
+        cur_size -= worst->size;
     }
+    g_list_free_full(worst_dirs, free);
 
 consider_processing:
     /* If the process survived cleaning up the dump location, append it to the
      * post-create queue.
      */
     if (proc != NULL)
+    {
+        free(proc->dedup_key);
+        proc->dedup_key = load_dedup_key(proc->dirname);
         s_dir_queue = g_list_append(s_dir_queue, proc);
+    }
 
-    /* If there were no running post-crate process before we added the
-     * currently handled process to the post-create queue, start processing of
-     * the currently handled process.
+    /* Start processing of the currently handled process if there is a free
+     * slot and no possible duplicate of it is being processed.
      */
-    if (running == NULL)
-        notify_next_post_create_process(NULL/*finished*/);
+    notify_next_post_create_process(NULL/*finished*/);
 }
 
 static gboolean abrt_server_output_cb(GIOChannel *channel, GIOCondition condition, gpointer user_data)
@@ -275,13 +443,25 @@ static gboolean abrt_server_output_cb(GIOChannel *channel, GIOCondition conditio
                 log_warning("abrt-server(%d): already handling: %s", proc->pid, proc->dirname);
                 free(proc->dirname);
                 /* Because process can be only once in the dir queue */
-                s_dir_queue = g_list_remove(s_dir_queue, proc);
+                dequeue_post_create_process(proc);
             }
 
             proc->dirname = xstrdup(line + strlen("NEW_PROBLEM_DETECTED: "));
             log_notice("abrt-server(%d): handling new problem: %s", proc->pid, proc->dirname);
             queue_post_craete_process(proc);
         }
+        else if (proc->control_fd >= 0 && strcmp(line, ABRT_SERVER_CLIENT_DONE) == 0)
+        {
+            log_debug("abrt-server(%d): ready for the next client", proc->pid);
+            finish_abrt_server_client(proc);
+            proc->idle = true;
+        }
+        else if (proc->control_fd >= 0 && strcmp(line, ABRT_SERVER_RETIRING) == 0)
+        {
+            log_debug("abrt-server(%d): served its last client", proc->pid);
+            finish_abrt_server_client(proc);
+            proc->idle = false;
+        }
         else
             log("abrt-server(%d): not recognized message: '%s'", proc->pid, line);
 
@@ -291,12 +471,16 @@ static gboolean abrt_server_output_cb(GIOChannel *channel, GIOCondition conditio
     return TRUE; /* Keep this event */
 }
 
-static void add_abrt_server_proc(const pid_t pid, int fdout)
+static struct abrt_server_proc *add_abrt_server_proc(const pid_t pid, int fdout)
 {
     struct abrt_server_proc *proc = xmalloc(sizeof(*proc));
     proc->pid = pid;
     proc->fdout = fdout;
     proc->dirname = NULL;
+    proc->dedup_key = NULL;
+    proc->control_fd = -1;
+    proc->idle = false;
+    proc->served = false;
     proc->type = AS_UKNOWN;
     proc->channel = abrt_gio_channel_unix_new(proc->fdout);
     proc->watch_id = g_io_add_watch(proc->channel,
@@ -312,7 +496,7 @@ static void add_abrt_server_proc(const pid_t pid, int fdout)
     g_io_channel_set_buffered(proc->channel, TRUE);
 
     s_processes = g_list_append(s_processes, proc);
-    if (g_list_length(s_processes) >= MAX_CLIENT_COUNT)
+    if (g_list_length(s_processes) >= get_max_client_count())
     {
         error_msg("Too many clients, refusing connections to '%s'", SOCKET_FILE);
         /* To avoid infinite loop caused by the descriptor in "ready" state,
@@ -321,6 +505,8 @@ static void add_abrt_server_proc(const pid_t pid, int fdout)
         g_source_remove(channel_id_socket);
         channel_id_socket = 0;
     }
+
+    return proc;
 }
 
 static void start_idle_timeout(void)
@@ -345,6 +531,141 @@ static void kill_idle_timeout(void)
 
 static gboolean server_socket_cb(GIOChannel *source, GIOCondition condition, gpointer ptr_unused);
 
+/* Starts abrt-server for the client connected to the socket or, if the socket
+ * is -1, a resident abrt-server which gets clients by pass_client_to_pool().
+ */
+static struct abrt_server_proc *spawn_abrt_server(int socket)
+{
+    int control[2] = { -1, -1 };
+    if (socket < 0 && socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, control) != 0)
+    {
+        perror_msg("socketpair");
+        return NULL;
+    }
+
+    fflush(NULL); /* paranoia */
+
+    int pipefd[2];
+    xpipe(pipefd);
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror_msg("fork");
+        close(pipefd[0]);
+        close(pipefd[1]);
+        if (socket < 0)
+        {
+            close(control[0]);
+            close(control[1]);
+        }
+        return NULL;
+    }
+    if (pid == 0) /* child */
+    {
+        if (socket >= 0)
+        {
+            xdup2(socket, STDIN_FILENO);
+            xdup2(socket, STDOUT_FILENO);
+            close(socket);
+        }
+        else
+        {
+            xdup2(control[1], STDIN_FILENO);
+            close(control[0]);
+            close(control[1]);
+        }
+
+        close(pipefd[0]);
+        xmove_fd(pipefd[1], STDERR_FILENO);
+        if (socket < 0)
+            xdup2(STDERR_FILENO, STDOUT_FILENO);
+
+        char *argv[4];  /* abrt-server [-s] [-w] NULL */
+        char **pp = argv;
+        *pp++ = (char*)"abrt-server";
+        if (logmode & LOGMODE_JOURNAL)
+            *pp++ = (char*)"-s";
+        if (socket < 0)
+            *pp++ = (char*)"-w";
+        *pp = NULL;
+
+        execvp(argv[0], argv);
+        perror_msg_and_die("Can't execute '%s'", argv[0]);
+    }
+
+    /* parent */
+    close(pipefd[1]);
+    struct abrt_server_proc *proc = add_abrt_server_proc(pid, pipefd[0]);
+    if (socket < 0)
+    {
+        close(control[1]);
+        proc->control_fd = control[0];
+        proc->idle = true;
+    }
+
+    return proc;
+}
+
+static void start_abrt_server_pool(void)
+{
+    unsigned resident = 0;
+    for (GList *li = s_processes; li != NULL; li = g_list_next(li))
+        if (((struct abrt_server_proc *)li->data)->control_fd >= 0)
+            ++resident;
+
+    for (; resident < ABRT_SERVER_POOL_SIZE; ++resident)
+        if (spawn_abrt_server(/*resident*/-1) == NULL)
+            break;
+}
+
+/* Passes the client's socket to an idle resident abrt-server via SCM_RIGHTS.
+ * Returns false if there is no idle resident abrt-server.
+ */
+static bool pass_client_to_pool(int socket)
+{
+    for (GList *li = s_processes; li != NULL; li = g_list_next(li))
+    {
+        struct abrt_server_proc *proc = (struct abrt_server_proc *)li->data;
+        if (proc->control_fd < 0 || !proc->idle)
+            continue;
+
+        char byte = 0;
+        struct iovec iov = { .iov_base = &byte, .iov_len = sizeof(byte) };
+        union {
+            struct cmsghdr align;
+            char buf[CMSG_SPACE(sizeof(int))];
+        } control;
+        memset(&control, 0, sizeof(control));
+        struct msghdr msg = {
+            .msg_iov = &iov,
+            .msg_iovlen = 1,
+            .msg_control = control.buf,
+            .msg_controllen = sizeof(control.buf),
+        };
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &socket, sizeof(socket));
+
+        /* The process is idle, so its socket buffer is empty */
+        proc->idle = false;
+        if (sendmsg(proc->control_fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT) < 0)
+        {
+            /* The process is probably dying, SIGCHLD will clean it up */
+            perror_msg("Can't pass client to abrt-server(%d)", proc->pid);
+            continue;
+        }
+
+        proc->served = true;
+        log_debug("Client passed to abrt-server(%d)", proc->pid);
+        return true;
+    }
+
+    return false;
+}
+
 static void remove_abrt_server_proc(pid_t pid, int status)
 {
     GList *item = g_list_find_custom(s_processes, &pid, (GCompareFunc)abrt_server_compare_pid);
@@ -355,19 +676,19 @@ static void remove_abrt_server_proc(pid_t pid, int status)
     item->data = NULL;
     s_processes = g_list_delete_link(s_processes, item);
 
-    if (proc->type == AS_POST_CREATE)
-        notify_next_post_create_process(proc);
-    else
-    {   /* Make sure out-of-order exited abrt-server post-create processes do
-         * not stay in the post-create queue.
-         */
-        s_dir_queue = g_list_remove(s_dir_queue, proc);
-    }
+    finish_abrt_server_client(proc);
+
+    /* Replace the resident process unless it failed before serving anyone,
+     * for example because abrt-server can't be executed */
+    const bool respawn = proc->control_fd >= 0 && proc->served && channel_socket != NULL;
 
     dispose_abrt_server(proc);
     free(proc);
 
-    if (g_list_length(s_processes) < MAX_CLIENT_COUNT && !channel_id_socket)
+    if (respawn)
+        start_abrt_server_pool();
+
+    if (g_list_length(s_processes) < get_max_client_count() && !channel_id_socket)
     {
         log_info("Accepting connections on '%s'", SOCKET_FILE);
         channel_id_socket = add_watch_or_die(channel_socket, G_IO_IN | G_IO_PRI | G_IO_HUP, server_socket_cb);
@@ -378,7 +699,7 @@ static void remove_abrt_server_proc(pid_t pid, int status)
 static gboolean server_socket_cb(GIOChannel *source, GIOCondition condition, gpointer ptr_unused)
 {
     kill_idle_timeout();
-    load_abrt_conf();
+    load_abrt_conf_if_changed();
 
     int socket = accept(g_io_channel_unix_get_fd(source), NULL, NULL);
     if (socket == -1)
@@ -388,44 +709,11 @@ static gboolean server_socket_cb(GIOChannel *source, GIOCondition condition, gpo
     }
 
     log_notice("New client connected");
-    fflush(NULL); /* paranoia */
-
-    int pipefd[2];
-    xpipe(pipefd);
-
-    pid_t pid = fork();
-    if (pid < 0)
-    {
-        perror_msg("fork");
-        close(socket);
-        close(pipefd[0]);
-        close(pipefd[1]);
-        goto server_socket_finitio;
-    }
-    if (pid == 0) /* child */
-    {
-        xdup2(socket, STDIN_FILENO);
-        xdup2(socket, STDOUT_FILENO);
-        close(socket);
-
-        close(pipefd[0]);
-        xmove_fd(pipefd[1], STDERR_FILENO);
-
-        char *argv[3];  /* abrt-server [-s] NULL */
-        char **pp = argv;
-        *pp++ = (char*)"abrt-server";
-        if (logmode & LOGMODE_JOURNAL)
-            *pp++ = (char*)"-s";
-        *pp = NULL;
 
-        execvp(argv[0], argv);
-        perror_msg_and_die("Can't execute '%s'", argv[0]);
-    }
+    if (!pass_client_to_pool(socket))
+        spawn_abrt_server(socket);
 
-    /* parent */
     close(socket);
-    close(pipefd[1]);
-    add_abrt_server_proc(pid, pipefd[0]);
 
 server_socket_finitio:
     start_idle_timeout();
@@ -789,6 +1077,9 @@ int main(int argc, char** argv)
     sanitize_dump_dir_rights();
     mark_unprocessed_dump_dirs_not_reportable(g_settings_dump_location);
 
+    s_problem_info_cache = problem_info_cache_new(g_settings_dump_location);
+    s_post_create_keys = g_hash_table_new(g_str_hash, g_str_equal);
+
     /* Daemonize unless -d */
     if (!(opts & OPT_d))
     {
@@ -851,6 +1142,7 @@ int main(int argc, char** argv)
 
     /* Open socket to receive new problem data (from python etc). */
     dumpsocket_init();
+    start_abrt_server_pool();
 
     /* Inform parent that we initialized ok */
     if (!(opts & OPT_d))
@@ -875,6 +1167,9 @@ int main(int argc, char** argv)
 
     start_idle_timeout();
 
+    /* Catch up with problems created or deleted while abrtd was not running */
+    schedule_problem_info_cache_sync();
+
     /* Enter the event loop */
     log_debug("Init complete, entering main loop");
     g_main_loop_run(s_main_loop);
@@ -910,6 +1205,12 @@ int main(int argc, char** argv)
 
     abrt_inotify_watch_destroy(aiw);
 
+    if (s_problem_info_sync_src > 0)
+        g_source_remove(s_problem_info_sync_src);
+    problem_info_cache_free(s_problem_info_cache);
+    if (s_post_create_keys != NULL)
+        g_hash_table_destroy(s_post_create_keys);
+
     if (s_main_loop)
         g_main_loop_unref(s_main_loop);
 
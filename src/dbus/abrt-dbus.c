@@ -20,6 +20,8 @@ static guint g_timeout_source;
 static unsigned g_timeout_value = 120;
 static guint g_signal_crash;
 static guint g_signal_dup_crash;
+/* Elements of problems needed for listing, maintained by abrtd */
+static problem_info_cache_t *g_problem_info_cache;
 
 /* ---------------------------------------------------------------------------------------------------- */
 
@@ -328,6 +330,28 @@ static int add_dirname_to_GList_if_matches(struct dump_dir *dd, void *arg)
     return 0;
 }
 
+/* Takes ownership of dirs */
+static GList *filter_problem_dirs_accessible_by_uid(GList *dirs, uid_t uid)
+{
+    GList *result = NULL;
+    for (GList *l = dirs; l; l = l->next)
+    {
+        struct dump_dir *dd = dd_opendir(l->data,   DD_OPEN_FD_ONLY
+                                                  | DD_FAIL_QUIETLY_ENOENT
+                                                  | DD_FAIL_QUIETLY_EACCES);
+        if (dd != NULL && dd_accessible_by_uid(dd, uid))
+            result = g_list_prepend(result, l->data);
+        else
+            free(l->data);
+
+        if (dd != NULL)
+            dd_close(dd);
+    }
+    g_list_free(dirs);
+
+    return g_list_reverse(result);
+}
+
 static GList *get_problem_dirs_for_element_in_time(uid_t uid,
                 const char *element,
                 const char *value,
@@ -337,6 +361,12 @@ static GList *get_problem_dirs_for_element_in_time(uid_t uid,
     if (timestamp_to == 0) /* not sure this is possible, but... */
         timestamp_to = time(NULL);
 
+    /* Commonly queried elements are indexed in the problem info cache */
+    GList *dirs = NULL;
+    if (problem_info_cache_find(g_problem_info_cache, element, value,
+                                timestamp_from, timestamp_to, &dirs) == 0)
+        return filter_problem_dirs_accessible_by_uid(dirs, uid);
+
     struct field_and_time_range me = {
         .list = NULL,
         .element = element,
@@ -520,6 +550,10 @@ static void handle_method_call(GDBusConnection *connection,
         g_variant_get_child(parameters, 0, "&s", &problem_dir);
         log_notice("problem_dir:'%s'", problem_dir);
 
+        /* Must be looked up before opening because locking of the directory
+         * changes its modification time */
+        const problem_info_t *pi = problem_info_cache_lookup(g_problem_info_cache, problem_dir);
+
         struct dump_dir *dd = open_dump_directory(invocation, caller, caller_uid,
                 problem_dir, DD_OPEN_READONLY | DD_FAIL_QUIETLY_EACCES , OPEN_AUTH_ASK);
         if (!dd)
@@ -534,18 +568,25 @@ static void handle_method_call(GDBusConnection *connection,
         for (GList *l = elements; l; l = l->next)
         {
             const char *element_name = (const char*)l->data;
-            char *value = dd_load_text_ext(dd, element_name, 0
+            const char *cached_value = NULL;
+            char *value = NULL;
+            if (pi == NULL || !problem_info_get_item(pi, element_name, &cached_value))
+                value = dd_load_text_ext(dd, element_name, 0
                                                 | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE
                                                 | DD_FAIL_QUIETLY_ENOENT
                                                 | DD_FAIL_QUIETLY_EACCES);
-            log_notice("element '%s' %s", element_name, value ? "fetched" : "not found");
-            if (value)
+            else
+                log_debug("element '%s' found in cache", element_name);
+
+            const char *result = value ? value : cached_value;
+            log_notice("element '%s' %s", element_name, result ? "fetched" : "not found");
+            if (result)
             {
                 if (!builder)
                     builder = g_variant_builder_new(G_VARIANT_TYPE_ARRAY);
 
                 /* g_variant_builder_add makes a copy. No need to xstrdup here */
-                g_variant_builder_add(builder, "{ss}", element_name, value);
+                g_variant_builder_add(builder, "{ss}", element_name, result);
                 free(value);
             }
         }
@@ -642,7 +683,7 @@ static void handle_method_call(GDBusConnection *connection,
         const double requested_size = (double)strlen(value) - item_size;
         /* Don't want to check the size limit in case of reducing of size */
         if (requested_size > 0
-            && requested_size > (max_dir_size - get_dirsize(g_settings_dump_location)))
+            && requested_size > (max_dir_size - get_dirsize_find_worst_dirs(g_settings_dump_location, NULL, NULL)))
         {
             log_notice("No problem space left in '%s' (requested Bytes %f)", problem_id, requested_size);
             g_dbus_method_invocation_return_dbus_error(invocation,
@@ -1090,6 +1131,8 @@ int main(int argc, char *argv[])
     /* initialize the g_settings_dump_location */
     load_abrt_conf();
 
+    g_problem_info_cache = problem_info_cache_new(g_settings_dump_location);
+
     loop = g_main_loop_new(NULL, FALSE);
     g_main_loop_run(loop);
 
@@ -1099,6 +1142,7 @@ int main(int argc, char *argv[])
 
     g_dbus_node_info_unref(introspection_data);
 
+    problem_info_cache_free(g_problem_info_cache);
     free_abrt_conf_data();
 
     return 0;
@@ -26,6 +26,24 @@ typedef struct
 {
     char *p2e_dirname;
     AbrtP2EntryState p2e_state;
+
+    /* The cached attributes and the result of the last access check are valid
+     * as long as the problem directory's inode and change time are equal to
+     * the following values. Adding, removing or renaming a file in
+     * the directory and changing the directory's owner or permissions
+     * updates the change time. */
+    ino_t p2e_cache_ino;
+    struct timespec p2e_cache_ctime;
+
+    bool p2e_attributes_valid;
+    AbrtP2EntryAttributes p2e_attributes;
+
+    /* D-Bus property name -> GVariant value */
+    GHashTable *p2e_properties;
+
+    bool p2e_access_valid;
+    uid_t p2e_access_uid;
+    int p2e_access_result;
 } AbrtP2EntryPrivate;
 
 struct _AbrtP2Entry
@@ -36,10 +54,22 @@ struct _AbrtP2Entry
 
 G_DEFINE_TYPE_WITH_PRIVATE(AbrtP2Entry, abrt_p2_entry, G_TYPE_OBJECT)
 
+static void abrt_p2_entry_attributes_clear(AbrtP2EntryAttributes *attrs)
+{
+    free(attrs->type);
+    free(attrs->executable);
+    free(attrs->component);
+    memset(attrs, 0, sizeof(*attrs));
+}
+
 static void abrt_p2_entry_finalize(GObject *gobject)
 {
     AbrtP2EntryPrivate *pv = abrt_p2_entry_get_instance_private(ABRT_P2_ENTRY(gobject));
     free(pv->p2e_dirname);
+    abrt_p2_entry_attributes_clear(&pv->p2e_attributes);
+
+    if (pv->p2e_properties != NULL)
+        g_hash_table_destroy(pv->p2e_properties);
 }
 
 static void abrt_p2_entry_class_init(AbrtP2EntryClass *klass)
@@ -83,23 +113,68 @@ const char *abrt_p2_entry_problem_id(AbrtP2Entry *entry)
     return entry->pv->p2e_dirname;
 }
 
-int abrt_p2_entry_accessible_by_uid(AbrtP2Entry *entry,
+/* Drops the cached data if the problem directory has changed */
+static void abrt_p2_entry_validate_cache(AbrtP2Entry *entry)
+{
+    AbrtP2EntryPrivate *pv = entry->pv;
+
+    struct stat st;
+    const bool exists = stat(pv->p2e_dirname, &st) == 0;
+    if (exists
+        && st.st_ino == pv->p2e_cache_ino
+        && st.st_ctim.tv_sec == pv->p2e_cache_ctime.tv_sec
+        && st.st_ctim.tv_nsec == pv->p2e_cache_ctime.tv_nsec)
+        return;
+
+    pv->p2e_attributes_valid = false;
+    pv->p2e_access_valid = false;
+
+    if (pv->p2e_properties != NULL)
+        g_hash_table_remove_all(pv->p2e_properties);
+
+    /* Time stamps have a coarse granularity, so a change made in the same
+     * time slice would not be noticed. Do not remember too recent times. */
+    if (!exists || st.st_ctim.tv_sec >= time(NULL) - 1)
+    {
+        pv->p2e_cache_ino = 0;
+        memset(&pv->p2e_cache_ctime, 0, sizeof(pv->p2e_cache_ctime));
+    }
+    else
+    {
+        pv->p2e_cache_ino = st.st_ino;
+        pv->p2e_cache_ctime = st.st_ctim;
+    }
+}
+
+static int abrt_p2_entry_check_access(AbrtP2Entry *entry,
             uid_t uid,
             struct dump_dir **dd)
 {
-    struct dump_dir *tmp = dd_opendir(entry->pv->p2e_dirname, DD_OPEN_FD_ONLY
-                                                              | DD_FAIL_QUIETLY_ENOENT
-                                                              | DD_FAIL_QUIETLY_EACCES);
+    AbrtP2EntryPrivate *pv = entry->pv;
+
+    if (dd == NULL && pv->p2e_access_valid && pv->p2e_access_uid == uid)
+        return pv->p2e_access_result;
+
+    struct dump_dir *tmp = dd_opendir(pv->p2e_dirname, DD_OPEN_FD_ONLY
+                                                       | DD_FAIL_QUIETLY_ENOENT
+                                                       | DD_FAIL_QUIETLY_EACCES);
     if (tmp == NULL)
     {
         VERB2 perror_msg("can't open problem directory '%s'",
-                         entry->pv->p2e_dirname);
+                         pv->p2e_dirname);
 
         return -ENOTDIR;
     }
 
     const int ret = dd_accessible_by_uid(tmp, uid) ? 0 : -EACCES;
 
+    if (dd == NULL)
+    {
+        pv->p2e_access_valid = true;
+        pv->p2e_access_uid = uid;
+        pv->p2e_access_result = ret;
+    }
+
     if (ret == 0 && dd != NULL)
         *dd = tmp;
     else
@@ -108,6 +183,118 @@ int abrt_p2_entry_accessible_by_uid(AbrtP2Entry *entry,
     return ret;
 }
 
+int abrt_p2_entry_accessible_by_uid(AbrtP2Entry *entry,
+            uid_t uid,
+            struct dump_dir **dd)
+{
+    if (dd == NULL)
+        abrt_p2_entry_validate_cache(entry);
+
+    return abrt_p2_entry_check_access(entry, uid, dd);
+}
+
+static char *load_attribute(struct dump_dir *dd, const char *name)
+{
+    return dd_load_text_ext(dd, name, DD_FAIL_QUIETLY_ENOENT
+                                      | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
+}
+
+static unsigned long load_numeric_attribute(struct dump_dir *dd, const char *name,
+            unsigned long def)
+{
+    char *value = load_attribute(dd, name);
+    if (value == NULL)
+        return def;
+
+    char *end = NULL;
+    errno = 0;
+    const unsigned long number = strtoul(value, &end, 10);
+    if (errno != 0 || end == value || *end != '\0')
+    {
+        log_debug("'%s' is not a number: '%s'", name, value);
+        free(value);
+        return def;
+    }
+
+    free(value);
+    return number;
+}
+
+static const AbrtP2EntryAttributes *abrt_p2_entry_load_attributes(AbrtP2Entry *entry)
+{
+    AbrtP2EntryPrivate *pv = entry->pv;
+
+    if (pv->p2e_attributes_valid)
+        return &pv->p2e_attributes;
+
+    abrt_p2_entry_attributes_clear(&pv->p2e_attributes);
+
+    /* Locking would change the directory and invalidate the cache */
+    struct dump_dir *dd = dd_opendir(pv->p2e_dirname, DD_OPEN_FD_ONLY
+                                                      | DD_FAIL_QUIETLY_ENOENT
+                                                      | DD_FAIL_QUIETLY_EACCES);
+    if (dd == NULL)
+    {
+        log_debug("Can't load attributes of '%s'", pv->p2e_dirname);
+        return &pv->p2e_attributes;
+    }
+
+    AbrtP2EntryAttributes *attrs = &pv->p2e_attributes;
+    attrs->type = load_attribute(dd, FILENAME_TYPE);
+    attrs->executable = load_attribute(dd, FILENAME_EXECUTABLE);
+    attrs->component = load_attribute(dd, FILENAME_COMPONENT);
+    attrs->first_occurrence = load_numeric_attribute(dd, FILENAME_TIME, 0);
+    attrs->last_occurrence = load_numeric_attribute(dd, FILENAME_LAST_OCCURRENCE,
+                                                    attrs->first_occurrence);
+    attrs->count = load_numeric_attribute(dd, FILENAME_COUNT, 1);
+
+    dd_close(dd);
+
+    pv->p2e_attributes_valid = true;
+    return attrs;
+}
+
+const AbrtP2EntryAttributes *abrt_p2_entry_attributes_accessible_by_uid(AbrtP2Entry *entry,
+            uid_t uid)
+{
+    /* The directory is checked for changes only once for both */
+    abrt_p2_entry_validate_cache(entry);
+
+    if (abrt_p2_entry_check_access(entry, uid, NULL) != 0)
+        return NULL;
+
+    return abrt_p2_entry_load_attributes(entry);
+}
+
+GVariant *abrt_p2_entry_lookup_property(AbrtP2Entry *entry, const char *name)
+{
+    AbrtP2EntryPrivate *pv = entry->pv;
+
+    abrt_p2_entry_validate_cache(entry);
+    if (pv->p2e_properties == NULL)
+        return NULL;
+
+    GVariant *value = g_hash_table_lookup(pv->p2e_properties, name);
+    return value != NULL ? g_variant_ref(value) : NULL;
+}
+
+bool abrt_p2_entry_cache_property(AbrtP2Entry *entry, const char *name, GVariant *value)
+{
+    AbrtP2EntryPrivate *pv = entry->pv;
+
+    /* The change time of the directory is too recent to be trusted */
+    if (pv->p2e_cache_ino == 0)
+        return false;
+
+    if (pv->p2e_properties == NULL)
+        pv->p2e_properties = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                   g_free,
+                                                   (GDestroyNotify)g_variant_unref);
+
+    g_hash_table_replace(pv->p2e_properties, g_strdup(name), g_variant_ref(value));
+    return true;
+}
+
 int abrt_p2_entry_delete(AbrtP2Entry *entry, uid_t caller_uid, GError **error)
 {
     struct dump_dir *dd = NULL;
@@ -225,6 +412,36 @@ struct dump_dir *abrt_p2_entry_open_dump_dir(AbrtP2Entry *entry,
 /**
  * Read elements
  */
+
+/* Reads at most length Bytes from offset into a NUL terminated buffer.
+ * Returns NULL on error. */
+static char *read_element_range(int fd, off_t offset, size_t length, size_t *size)
+{
+    char *data = xmalloc(length + 1);
+    size_t total = 0;
+    while (total < length)
+    {
+        const ssize_t r = pread(fd, data + total, length - total, offset + total);
+        if (r < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            free(data);
+            return NULL;
+        }
+
+        if (r == 0)
+            break;
+
+        total += r;
+    }
+
+    data[total] = '\0';
+    *size = total;
+    return data;
+}
+
 GVariant *abrt_p2_entry_read_elements(AbrtP2Entry *entry,
              gint32 flags,
              GVariant *elements,
@@ -260,8 +477,7 @@ GVariant *abrt_p2_entry_read_elements(AbrtP2Entry *entry,
     while (g_variant_iter_loop(&iter, "s", &name))
     {
         log_debug("Reading element: %s", name);
-        /* Do ask me why -> see libreport xmalloc_read() */
-        size_t data_size = (INT_MAX - 4095);
+        size_t data_size = 0;
 
         int elem_type = 0;
         char *data = NULL;
@@ -300,6 +516,7 @@ GVariant *abrt_p2_entry_read_elements(AbrtP2Entry *entry,
             log_debug("Rewinding file descriptor %d", fd);
 
             free(data);
+            data = NULL;
             if (lseek(fd, 0, SEEK_SET))
             {
                 perror_msg("Failed to rewind file descriptor of %s", name);
@@ -341,17 +558,23 @@ GVariant *abrt_p2_entry_read_elements(AbrtP2Entry *entry,
             continue;
         }
 
+        /* Check the limits before a non-text element is read */
         if (!(elem_type & CD_FLAG_TXT))
         {
-            data = xmalloc_read(fd, &data_size);
+            struct stat st;
+            if (fstat(fd, &st) != 0)
+            {
+                perror_msg("Failed to stat %s", name);
 
-            log_debug("Re-loaded entire element: %zu Bytes", data_size);
+                close(fd);
+                continue;
+            }
+
+            data_size = st.st_size;
         }
         else
             data_size = strlen(data);
 
-        close(fd);
-
         if (data_size > DBUS_MAXIMUM_ARRAY_LENGTH)
         {
             error_msg("Element '%s' cannot be returned as array due to length limit: %ld",
@@ -359,6 +582,7 @@ GVariant *abrt_p2_entry_read_elements(AbrtP2Entry *entry,
                       (long)DBUS_MAXIMUM_ARRAY_LENGTH);
 
             free(data);
+            close(fd);
 
             continue;
         }
@@ -370,6 +594,7 @@ GVariant *abrt_p2_entry_read_elements(AbrtP2Entry *entry,
                       max_size);
 
             free(data);
+            close(fd);
 
             continue;
         }
@@ -381,31 +606,49 @@ GVariant *abrt_p2_entry_read_elements(AbrtP2Entry *entry,
                       max_size);
 
             free(data);
+            close(fd);
 
             continue;
         }
 
+        if (!(elem_type & CD_FLAG_TXT))
+        {
+            data = read_element_range(fd, 0, data_size, &data_size);
+            if (data == NULL)
+            {
+                perror_msg("Failed to read %s", name);
+
+                close(fd);
+                continue;
+            }
+
+            log_debug("Re-loaded entire element: %zu Bytes", data_size);
+        }
+
+        close(fd);
+
         loaded_size += data_size;
 
+        /* The variants take the buffers over, so the data are not copied */
         if (elem_type & CD_FLAG_BIN)
         {
             log_debug("Adding element binary data");
             g_variant_builder_add(&builder, "{sv}",
                                              name,
-                                             g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE,
-                                                                       data,
-                                                                       data_size,
-                                                                       sizeof(char)));
+                                             g_variant_new_from_data(G_VARIANT_TYPE("ay"),
+                                                                     data,
+                                                                     data_size,
+                                                                     TRUE,
+                                                                     free,
+                                                                     data));
         }
         else
         {
             log_debug("Adding element text data");
             g_variant_builder_add(&builder, "{sv}",
                                             name,
-                                            g_variant_new_string(data));
+                                            g_variant_new_take_string(data));
         }
-
-        free(data);
     }
 
     dd_close(dd);
@@ -494,6 +737,177 @@ GVariant *abrt_p2_entry_read_elements_finish(AbrtP2Entry *entry,
     return g_task_propagate_pointer(G_TASK(result), error);
 }
 
+/**
+ * Read a range of an element
+ */
+GVariant *abrt_p2_entry_read_element_range(AbrtP2Entry *entry,
+            const char *name,
+            guint64 offset,
+            guint64 length,
+            uid_t caller_uid,
+            long max_size,
+            GError **error)
+{
+    struct dump_dir *dd = abrt_p2_entry_open_dump_dir(entry,
+                                                      caller_uid,
+                                                      DD_OPEN_READONLY | DD_DONT_WAIT_FOR_LOCK,
+                                                      error);
+    if (dd == NULL)
+        return NULL;
+
+    /* problem_data_load_dump_dir_element() rejects the same names */
+    if (!str_is_correct_filename(name))
+    {
+        dd_close(dd);
+        error_msg("Attempt to read prohibited data: '%s'", name);
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                    "Cannot read element '%s'", name);
+        return NULL;
+    }
+
+    /* Only the range is read, the element is never loaded as a whole.
+     * O_NONBLOCK prevents blocking on FIFOs, which are rejected below. */
+    const int fd = openat(dd->dd_fd, name, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+    const int err = errno;
+    dd_close(dd);
+
+    if (fd < 0)
+    {
+        if (err != ENOENT)
+            error_msg("Failed to open %s: %s", name, strerror(err));
+
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                    "Cannot read element '%s'", name);
+        return NULL;
+    }
+
+    struct stat st;
+    const int stat_rc = fstat(fd, &st);
+    /* Hard links could expose files from outside of the problem directory */
+    if (stat_rc != 0 || !S_ISREG(st.st_mode) || st.st_nlink > 1)
+    {
+        if (stat_rc != 0)
+            perror_msg("Failed to stat %s", name);
+        else
+            error_msg("Element '%s' is not a regular file with a single link", name);
+
+        close(fd);
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_IO_ERROR,
+                    "Cannot read element '%s'", name);
+        return NULL;
+    }
+
+    /* Return a shorter range rather than an error, the client reads the rest
+     * by next calls */
+    const guint64 size = st.st_size;
+    const guint64 available = offset < size ? size - offset : 0;
+    if (length == 0 || length > available)
+        length = available;
+
+    if (length > ABRT_P2_ENTRY_READ_RANGE_MAX)
+        length = ABRT_P2_ENTRY_READ_RANGE_MAX;
+
+    if (length > (guint64)max_size)
+        length = max_size;
+
+    if (length > (guint64)DBUS_MAXIMUM_ARRAY_LENGTH)
+        length = DBUS_MAXIMUM_ARRAY_LENGTH;
+
+    size_t data_size = 0;
+    char *data = read_element_range(fd, offset, length, &data_size);
+    close(fd);
+    if (data == NULL)
+    {
+        perror_msg("Failed to read %s", name);
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_IO_ERROR,
+                    "Cannot read element '%s'", name);
+        return NULL;
+    }
+
+    log_debug("Read %zu Bytes of %s at offset %llu", data_size, name, (unsigned long long)offset);
+
+    GVariant *retval_body[2];
+    retval_body[0] = g_variant_new_from_data(G_VARIANT_TYPE("ay"), data, data_size, TRUE, free, data);
+    retval_body[1] = g_variant_new_uint64(size);
+    return g_variant_new_tuple(retval_body, ARRAY_SIZE(retval_body));
+}
+
+/**
+ * Asynchronous version of Read a range of an element
+ */
+typedef struct
+{
+    char *name;
+    guint64 offset;
+    guint64 length;
+    uid_t caller_uid;
+    long  max_size;
+} AbrtP2EntryReadElementRangeData;
+
+#define abrt_p2_entry_read_element_range_data_new() \
+    xmalloc(sizeof(AbrtP2EntryReadElementRangeData))
+
+static inline void abrt_p2_entry_read_element_range_data_free(AbrtP2EntryReadElementRangeData *data)
+{
+    free(data->name);
+    free(data);
+}
+
+static void abrt_p2_entry_read_element_range_async_task(GTask *task,
+            gpointer source_object,
+            gpointer task_data,
+            GCancellable *cancellable)
+{
+    AbrtP2Entry *entry = source_object;
+    AbrtP2EntryReadElementRangeData *data = task_data;
+
+    GError *error = NULL;
+    GVariant *response = abrt_p2_entry_read_element_range(entry,
+                                                          data->name,
+                                                          data->offset,
+                                                          data->length,
+                                                          data->caller_uid,
+                                                          data->max_size,
+                                                          &error);
+
+    if (error == NULL)
+        g_task_return_pointer(task, response, (GDestroyNotify)g_variant_unref);
+    else
+        g_task_return_error(task, error);
+}
+
+void abrt_p2_entry_read_element_range_async(AbrtP2Entry *entry,
+            const char *name,
+            guint64 offset,
+            guint64 length,
+            uid_t caller_uid,
+            long max_size,
+            GCancellable *cancellable,
+            GAsyncReadyCallback callback,
+            gpointer user_data)
+{
+    AbrtP2EntryReadElementRangeData *data = abrt_p2_entry_read_element_range_data_new();
+    data->name = xstrdup(name);
+    data->offset = offset;
+    data->length = length;
+    data->caller_uid = caller_uid;
+    data->max_size = max_size;
+
+    GTask *task = g_task_new(entry, cancellable, callback, user_data);
+    g_task_set_task_data(task, data, (GDestroyNotify)abrt_p2_entry_read_element_range_data_free);
+    g_task_run_in_thread(task, abrt_p2_entry_read_element_range_async_task);
+    g_object_unref(task);
+}
+
+GVariant *abrt_p2_entry_read_element_range_finish(AbrtP2Entry *entry,
+           GAsyncResult *result,
+           GError **error)
+{
+    g_return_val_if_fail(g_task_is_valid(result, entry), NULL);
+
+    return g_task_propagate_pointer(G_TASK(result), error);
+}
+
 /**
  * Save elements
  */
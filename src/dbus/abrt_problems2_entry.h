@@ -84,6 +84,41 @@ GVariant *abrt_p2_entry_delete_elements(AbrtP2Entry *entry,
  */
 uid_t abrt_p2_entry_get_owner(AbrtP2Entry *entry, GError **error);
 
+/*
+ * Attributes used for filtering and sorting of lists of problems
+ *
+ * The attributes are loaded once and reloaded only when the problem directory
+ * changes. Missing strings are NULL.
+ */
+typedef struct
+{
+    char *type;
+    char *executable;
+    char *component;
+    time_t first_occurrence;
+    time_t last_occurrence;
+    unsigned count;
+} AbrtP2EntryAttributes;
+
+/* Returns NULL if the problem is not accessible by the user */
+const AbrtP2EntryAttributes *abrt_p2_entry_attributes_accessible_by_uid(AbrtP2Entry *entry,
+            uid_t uid);
+
+/*
+ * Cache of D-Bus property values
+ *
+ * The values do not depend on the caller, so callers must check access to
+ * the problem on their own. The cache is dropped when the problem directory
+ * changes.
+ */
+
+/* Returns a new reference or NULL if the value is not cached */
+GVariant *abrt_p2_entry_lookup_property(AbrtP2Entry *entry, const char *name);
+
+/* Takes a new reference, the value must not be floating. Returns false if
+ * the directory has changed too recently to cache anything. */
+bool abrt_p2_entry_cache_property(AbrtP2Entry *entry, const char *name, GVariant *value);
+
 /*
  * Read elements
  */
@@ -121,6 +156,36 @@ GVariant *abrt_p2_entry_read_elements_finish(AbrtP2Entry *entry,
             GAsyncResult *result,
             GError **error);
 
+/*
+ * Returns (ayt) with at most length Bytes of the element from offset and the
+ * size of the whole element. The range is shortened to
+ * ABRT_P2_ENTRY_READ_RANGE_MAX Bytes and to fit into the message size limit.
+ * Zero length means the rest of the element.
+ */
+#define ABRT_P2_ENTRY_READ_RANGE_MAX (1024 * 1024)
+
+GVariant *abrt_p2_entry_read_element_range(AbrtP2Entry *entry,
+            const char *name,
+            guint64 offset,
+            guint64 length,
+            uid_t caller_uid,
+            long max_size,
+            GError **error);
+
+void abrt_p2_entry_read_element_range_async(AbrtP2Entry *entry,
+            const char *name,
+            guint64 offset,
+            guint64 length,
+            uid_t caller_uid,
+            long max_size,
+            GCancellable *cancellable,
+            GAsyncReadyCallback callback,
+            gpointer user_data);
+
+GVariant *abrt_p2_entry_read_element_range_finish(AbrtP2Entry *entry,
+            GAsyncResult *result,
+            GError **error);
+
 /*
  * Save elements
  */
@@ -791,6 +791,26 @@ static void entry_object_read_elements_cb(GObject *source_object,
     free(context);
 }
 
+static void entry_object_read_element_range_cb(GObject *source_object,
+            GAsyncResult *result,
+            gpointer user_data)
+{
+    AbrtP2Entry *entry = ABRT_P2_ENTRY(source_object);
+    GDBusMethodInvocation *invocation = user_data;
+
+    GError *error = NULL;
+    GVariant *response = abrt_p2_entry_read_element_range_finish(entry, result, &error);
+    if (error == NULL)
+        g_dbus_method_invocation_return_value(invocation, response);
+    else
+    {
+        g_dbus_method_invocation_return_gerror(invocation, error);
+        g_error_free(error);
+    }
+
+    g_object_unref(invocation);
+}
+
 static void entry_object_dbus_method_call(GDBusConnection *connection,
             const gchar *caller,
             const gchar *object_path,
@@ -848,6 +868,25 @@ static void entry_object_dbus_method_call(GDBusConnection *connection,
 
         return;
     }
+    else if (strcmp(method_name, "ReadElementRange") == 0)
+    {
+        const gchar *name;
+        guint64 offset;
+        guint64 length;
+        g_variant_get(parameters, "(&stt)", &name, &offset, &length);
+
+        /* Reading must not block other clients */
+        abrt_p2_entry_read_element_range_async(entry,
+                                               name,
+                                               offset,
+                                               length,
+                                               caller_uid,
+                                               service->pv->p2srv_max_message_size,
+                                               /*cancellable*/NULL,
+                                               entry_object_read_element_range_cb,
+                                               g_object_ref(invocation));
+        return;
+    }
     else if (strcmp(method_name, "SaveElements") == 0)
     {
         GDBusMessage *msg = g_dbus_method_invocation_get_message(invocation);
@@ -930,29 +969,11 @@ static void entry_object_dbus_method_call(GDBusConnection *connection,
 
 #define GET_UINT32_PROPERTY(name, element, def) GET_INTEGER_PROPERTY(name, element, 32, def)
 
-static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
-            const gchar *caller,
-            const gchar *object_path,
-            const gchar *interface_name,
+static GVariant *entry_object_load_property(struct dump_dir *dd,
             const gchar *property_name,
-            GError      **error,
-            gpointer    user_data)
+            GError **error)
 {
-    log_debug("Problems2.Entry get property : %s", property_name);
-
-    AbrtP2Service *service = abrt_p2_object_service(user_data);
-    uid_t caller_uid = abrt_p2_service_caller_uid(service, caller, error);
-    if (caller_uid == (uid_t)-1)
-        return NULL;
-
     GVariant *retval;
-    AbrtP2Entry *entry = abrt_p2_object_get_node(user_data);
-    struct dump_dir *dd = abrt_p2_entry_open_dump_dir(entry,
-                                                      caller_uid,
-                                                      DD_DONT_WAIT_FOR_LOCK | DD_OPEN_READONLY,
-                                                      error);
-    if (dd == NULL)
-        return NULL;
 
     if (strcmp("ID", property_name) == 0)
     {
@@ -979,7 +1000,6 @@ static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
         time_t tm = dd_get_first_occurrence(dd);
         if (tm == (time_t) -1)
         {
-            dd_close(dd);
             g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
                         "Invalid problem data: FirstOccurrence cannot be returned");
             return NULL;
@@ -994,7 +1014,6 @@ static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
         time_t ltm = dd_get_last_occurrence(dd);
         if (ltm == (time_t) -1)
         {
-            dd_close(dd);
             g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
                         "Invalid problem data: LastOccurrence cannot be returned");
             return NULL;
@@ -1122,14 +1141,111 @@ static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
        goto return_property_value;
     }
 
-    dd_close(dd);
     error_msg("Unknown property %s", property_name);
     g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_PROPERTY,
             "BUG: the property getter has to be implemented");
     return NULL;
 
 return_property_value:
-    dd_close(dd);
+    return retval;
+}
+
+static void entry_object_cache_properties(AbrtP2Entry *entry,
+            GDBusInterfaceInfo *iface,
+            struct dump_dir *dd,
+            const gchar *loaded_property)
+{
+    for (GDBusPropertyInfo **prop = iface->properties; *prop != NULL; ++prop)
+    {
+        if (strcmp((*prop)->name, loaded_property) == 0)
+            continue;
+
+        GError *local_error = NULL;
+        GVariant *value = entry_object_load_property(dd, (*prop)->name, &local_error);
+        if (value == NULL)
+        {
+            log_debug("Cannot cache property %s: %s", (*prop)->name, local_error->message);
+            g_error_free(local_error);
+            continue;
+        }
+
+        g_variant_ref_sink(value);
+        abrt_p2_entry_cache_property(entry, (*prop)->name, value);
+        g_variant_unref(value);
+    }
+}
+
+/* The caller must be allowed to access the entry. The dump directory is
+ * opened on the first value missing in the entry's cache and it is left open
+ * for the other properties of the same entry. */
+static GVariant *entry_object_get_property_value(AbrtP2Entry *entry,
+            GDBusInterfaceInfo *iface,
+            uid_t caller_uid,
+            const gchar *property_name,
+            struct dump_dir **dd,
+            GError **error)
+{
+    GVariant *value = abrt_p2_entry_lookup_property(entry, property_name);
+    if (value != NULL)
+        return value;
+
+    if (*dd == NULL)
+    {
+        /* Locking would change the directory and drop the cache */
+        *dd = abrt_p2_entry_open_dump_dir(entry, caller_uid, DD_OPEN_FD_ONLY, error);
+        if (*dd == NULL)
+            return NULL;
+    }
+
+    value = entry_object_load_property(*dd, property_name, error);
+    if (value == NULL)
+        return NULL;
+
+    g_variant_ref_sink(value);
+
+    /* Clients read several properties at once (GetAll, GetProblemsProperties)
+     * and the dump directory is already open, so load all of them */
+    if (abrt_p2_entry_cache_property(entry, property_name, value))
+        entry_object_cache_properties(entry, iface, *dd, property_name);
+
+    return value;
+}
+
+static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
+            const gchar *caller,
+            const gchar *object_path,
+            const gchar *interface_name,
+            const gchar *property_name,
+            GError      **error,
+            gpointer    user_data)
+{
+    log_debug("Problems2.Entry get property : %s", property_name);
+
+    AbrtP2Service *service = abrt_p2_object_service(user_data);
+    uid_t caller_uid = abrt_p2_service_caller_uid(service, caller, error);
+    if (caller_uid == (uid_t)-1)
+        return NULL;
+
+    AbrtP2Entry *entry = abrt_p2_object_get_node(user_data);
+    if (0 != abrt_p2_entry_accessible_by_uid(entry, caller_uid, NULL))
+    {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED,
+                    "You are not authorized to access the problem");
+        return NULL;
+    }
+
+    /* GetAll gets the properties one by one, so all values are served from
+     * the cache after the first one unless the directory has just changed */
+    struct dump_dir *dd = NULL;
+    GVariant *retval = entry_object_get_property_value(entry,
+                                                       service->pv->p2srv_p2_entry_type.iface,
+                                                       caller_uid,
+                                                       property_name,
+                                                       &dd,
+                                                       error);
+    if (dd != NULL)
+        dd_close(dd);
+
     return retval;
 }
 
@@ -1293,19 +1409,38 @@ static char *entry_object_dir_name_to_path(const char *dd_dirname)
     return xasprintf(ABRT_P2_PATH"/Entry/%s", hash_str);
 }
 
+static AbrtP2Object *entry_object_register_entry(AbrtP2Service *service,
+            struct _AbrtP2Entry *entry,
+            uid_t owner,
+            GError **error);
+
+/* The owner must be the owner of the directory as dd_get_owner() returns it */
 static AbrtP2Object *entry_object_register_dump_dir(AbrtP2Service *service,
                 const char *dd_dirname,
+                uid_t owner,
                 GError **error)
 {
     char *const dup_dirname = xstrdup(dd_dirname);
     AbrtP2Entry *entry = abrt_p2_entry_new(dup_dirname);
 
-    return abrt_p2_service_register_entry(service, entry, error);
+    return entry_object_register_entry(service, entry, owner, error);
 }
 
 AbrtP2Object *abrt_p2_service_register_entry(AbrtP2Service *service,
             struct _AbrtP2Entry *entry,
             GError **error)
+{
+    struct dump_dir *dd = dd_opendir(abrt_p2_entry_problem_id(entry), DD_OPEN_FD_ONLY);
+    uid_t owner = dd_get_owner(dd);
+    dd_close(dd);
+
+    return entry_object_register_entry(service, entry, owner, error);
+}
+
+static AbrtP2Object *entry_object_register_entry(AbrtP2Service *service,
+            struct _AbrtP2Entry *entry,
+            uid_t owner,
+            GError **error)
 {
     const char *dd_dirname = abrt_p2_entry_problem_id(entry);
     log_debug("Registering problem entry for directory: %s", dd_dirname);
@@ -1325,10 +1460,6 @@ AbrtP2Object *abrt_p2_service_register_entry(AbrtP2Service *service,
         return NULL;
     }
 
-    struct dump_dir *dd = dd_opendir(dd_dirname, DD_OPEN_FD_ONLY);
-    uid_t owner = dd_get_owner(dd);
-    dd_close(dd);
-
     struct user_info *user = abrt_p2_service_user_lookup(service, owner);
 
     if (user == NULL)
@@ -2022,14 +2153,240 @@ GVariant *abrt_p2_service_callers_session(AbrtP2Service *service,
     return g_variant_new("(o)", session_path);
 }
 
+/*
+ * GetProblems options
+ */
+enum get_problems_sort_key
+{
+    GET_PROBLEMS_SORT_NONE,
+    GET_PROBLEMS_SORT_TIME,
+    GET_PROBLEMS_SORT_LAST_OCCURRENCE,
+    GET_PROBLEMS_SORT_COUNT,
+    GET_PROBLEMS_SORT_TYPE,
+    GET_PROBLEMS_SORT_EXECUTABLE,
+    GET_PROBLEMS_SORT_COMPONENT,
+};
+
+static const char *const get_problems_sort_key_names[] = {
+    [GET_PROBLEMS_SORT_TIME]            = FILENAME_TIME,
+    [GET_PROBLEMS_SORT_LAST_OCCURRENCE] = FILENAME_LAST_OCCURRENCE,
+    [GET_PROBLEMS_SORT_COUNT]           = FILENAME_COUNT,
+    [GET_PROBLEMS_SORT_TYPE]            = FILENAME_TYPE,
+    [GET_PROBLEMS_SORT_EXECUTABLE]      = FILENAME_EXECUTABLE,
+    [GET_PROBLEMS_SORT_COMPONENT]       = FILENAME_COMPONENT,
+};
+
+struct get_problems_options
+{
+    const char *type;
+    const char *executable;
+    const char *component;
+    guint64 since;
+    guint64 until;
+    guint32 min_count;
+    enum get_problems_sort_key sort_by;
+    gboolean sort_descending;
+    guint32 offset;
+    guint32 limit;              ///< 0 means unlimited
+};
+
+static bool get_problems_options_filter(const struct get_problems_options *opts)
+{
+    return opts->type != NULL || opts->executable != NULL || opts->component != NULL
+        || opts->since != 0 || opts->until != G_MAXUINT64 || opts->min_count > 1;
+}
+
+static const struct
+{
+    const char *name;
+    const char *type;
+} get_problems_option_types[] = {
+    { "type",            "s" },
+    { "executable",      "s" },
+    { "component",       "s" },
+    { "since",           "t" },
+    { "until",           "t" },
+    { "min_count",       "u" },
+    { "sort_by",         "s" },
+    { "sort_descending", "b" },
+    { "offset",          "u" },
+    { "limit",           "u" },
+};
+
+static int get_problems_option_check_type(const char *key,
+            GVariant *value,
+            GError **error)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(get_problems_option_types); ++i)
+    {
+        if (strcmp(get_problems_option_types[i].name, key) != 0)
+            continue;
+
+        const char *type = get_problems_option_types[i].type;
+        if (g_variant_is_of_type(value, G_VARIANT_TYPE(type)))
+            return 0;
+
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                    "Option '%s' must be of type '%s'", key, type);
+        return -EINVAL;
+    }
+
+    g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                "Unknown option '%s'", key);
+    return -EINVAL;
+}
+
+/* The returned strings point into the options variant */
+static int get_problems_options_parse(struct get_problems_options *opts,
+            GVariant *options,
+            GError **error)
+{
+    memset(opts, 0, sizeof(*opts));
+    opts->until = G_MAXUINT64;
+
+    int retval = 0;
+    GVariantIter iter;
+    const gchar *key;
+    GVariant *value;
+    g_variant_iter_init(&iter, options);
+    while (retval == 0 && g_variant_iter_next(&iter, "{&sv}", &key, &value))
+    {
+        retval = get_problems_option_check_type(key, value, error);
+        if (retval != 0)
+            ;
+        else if (strcmp("type", key) == 0)
+            opts->type = g_variant_get_string(value, NULL);
+        else if (strcmp("executable", key) == 0)
+            opts->executable = g_variant_get_string(value, NULL);
+        else if (strcmp("component", key) == 0)
+            opts->component = g_variant_get_string(value, NULL);
+        else if (strcmp("since", key) == 0)
+            opts->since = g_variant_get_uint64(value);
+        else if (strcmp("until", key) == 0)
+            opts->until = g_variant_get_uint64(value);
+        else if (strcmp("min_count", key) == 0)
+            opts->min_count = g_variant_get_uint32(value);
+        else if (strcmp("sort_descending", key) == 0)
+            opts->sort_descending = g_variant_get_boolean(value);
+        else if (strcmp("offset", key) == 0)
+            opts->offset = g_variant_get_uint32(value);
+        else if (strcmp("limit", key) == 0)
+            opts->limit = g_variant_get_uint32(value);
+        else if (strcmp("sort_by", key) == 0)
+        {
+            const char *name = g_variant_get_string(value, NULL);
+            for (size_t i = 0; i < ARRAY_SIZE(get_problems_sort_key_names); ++i)
+            {
+                if (get_problems_sort_key_names[i] != NULL
+                    && strcmp(get_problems_sort_key_names[i], name) == 0)
+                {
+                    opts->sort_by = i;
+                    break;
+                }
+            }
+
+            if (opts->sort_by == GET_PROBLEMS_SORT_NONE)
+            {
+                g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                            "Cannot sort problems by '%s'", name);
+                retval = -EINVAL;
+            }
+        }
+
+        g_variant_unref(value);
+    }
+
+    return retval;
+}
+
+/* A problem matching the filter */
+struct get_problems_candidate
+{
+    const char *path;
+    const AbrtP2EntryAttributes *attrs;
+};
+
+static bool get_problems_attributes_match(const AbrtP2EntryAttributes *attrs,
+            const struct get_problems_options *opts)
+{
+    if (opts->type != NULL && g_strcmp0(opts->type, attrs->type) != 0)
+        return false;
+
+    if (opts->executable != NULL && g_strcmp0(opts->executable, attrs->executable) != 0)
+        return false;
+
+    if (opts->component != NULL && g_strcmp0(opts->component, attrs->component) != 0)
+        return false;
+
+    /* The problem occurred in the time range */
+    if ((guint64)attrs->last_occurrence < opts->since
+        || (guint64)attrs->first_occurrence > opts->until)
+        return false;
+
+    return attrs->count >= opts->min_count;
+}
+
+static gint get_problems_candidate_cmp(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const struct get_problems_candidate *lhs = a;
+    const struct get_problems_candidate *rhs = b;
+    const struct get_problems_options *opts = user_data;
+
+    int r = 0;
+    switch (opts->sort_by)
+    {
+        case GET_PROBLEMS_SORT_TIME:
+            r = (lhs->attrs->first_occurrence > rhs->attrs->first_occurrence)
+              - (lhs->attrs->first_occurrence < rhs->attrs->first_occurrence);
+            break;
+        case GET_PROBLEMS_SORT_LAST_OCCURRENCE:
+            r = (lhs->attrs->last_occurrence > rhs->attrs->last_occurrence)
+              - (lhs->attrs->last_occurrence < rhs->attrs->last_occurrence);
+            break;
+        case GET_PROBLEMS_SORT_COUNT:
+            r = (lhs->attrs->count > rhs->attrs->count)
+              - (lhs->attrs->count < rhs->attrs->count);
+            break;
+        case GET_PROBLEMS_SORT_TYPE:
+            r = g_strcmp0(lhs->attrs->type, rhs->attrs->type);
+            break;
+        case GET_PROBLEMS_SORT_EXECUTABLE:
+            r = g_strcmp0(lhs->attrs->executable, rhs->attrs->executable);
+            break;
+        case GET_PROBLEMS_SORT_COMPONENT:
+            r = g_strcmp0(lhs->attrs->component, rhs->attrs->component);
+            break;
+        case GET_PROBLEMS_SORT_NONE:
+            break;
+    }
+
+    /* Stable order for paging */
+    if (r == 0)
+        return strcmp(lhs->path, rhs->path);
+
+    return opts->sort_descending ? -r : r;
+}
+
 GVariant *abrt_p2_service_get_problems(AbrtP2Service *service,
                 uid_t caller_uid,
                 gint32 flags,
                 GVariant *options,
                 GError **error)
 {
-    GVariantBuilder builder;
-    g_variant_builder_init(&builder, G_VARIANT_TYPE("ao"));
+    struct get_problems_options opts;
+    if (get_problems_options_parse(&opts, options, error) != 0)
+        return NULL;
+
+    /* Attributes of problems the caller cannot access must not be revealed,
+     * so such problems never match a filter and they are sorted as problems
+     * without attributes. Pages are sorted by paths if no key is given. */
+    static const AbrtP2EntryAttributes no_attributes = { .count = 0 };
+    const bool filter = get_problems_options_filter(&opts);
+    const bool paging = opts.sort_by != GET_PROBLEMS_SORT_NONE
+                        || opts.offset != 0
+                        || opts.limit != 0;
+
+    GArray *candidates = g_array_new(FALSE, FALSE, sizeof(struct get_problems_candidate));
 
     GHashTableIter iter;
     g_hash_table_iter_init(&iter, service->pv->p2srv_p2_entry_type.objects);
@@ -2057,7 +2414,22 @@ GVariant *abrt_p2_service_get_problems(AbrtP2Service *service,
             singleout = singleout || (flags & ABRT_P2_SERVICE_GET_PROBLEM_FLAGS_NEW);
         }
 
-        if (0 != abrt_p2_entry_accessible_by_uid(entry, caller_uid, NULL))
+        /* Filtering and sorting need the attributes of accessible problems,
+         * read them together with the access check */
+        const AbrtP2EntryAttributes *attrs = NULL;
+        bool accessible;
+        if (filter || paging)
+        {
+            attrs = abrt_p2_entry_attributes_accessible_by_uid(entry, caller_uid);
+            accessible = attrs != NULL;
+        }
+        else
+            accessible = 0 == abrt_p2_entry_accessible_by_uid(entry, caller_uid, NULL);
+
+        if (attrs == NULL)
+            attrs = &no_attributes;
+
+        if (!accessible)
         {
             if (flags == 0)
                 continue;
@@ -2066,13 +2438,43 @@ GVariant *abrt_p2_service_get_problems(AbrtP2Service *service,
             singleout = singleout || (flags & ABRT_P2_SERVICE_GET_PROBLEM_FLAGS_FOREIGN);
         }
 
-        if (singleout)
-        {
-            log_debug("Adding entry: %s", entry_path);
-            g_variant_builder_add(&builder, "o", entry_path);
-        }
+        if (!singleout)
+            continue;
+
+        if (filter && (attrs == &no_attributes
+                       || !get_problems_attributes_match(attrs, &opts)))
+            continue;
+
+        struct get_problems_candidate candidate = {
+            .path = entry_path,
+            .attrs = attrs,
+        };
+        g_array_append_val(candidates, candidate);
     }
 
+    if (paging)
+        g_array_sort_with_data(candidates, get_problems_candidate_cmp, &opts);
+
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("ao"));
+
+    guint end = candidates->len;
+    if (opts.limit != 0 && opts.limit < end - MIN(opts.offset, end))
+        end = opts.offset + opts.limit;
+
+    for (guint i = opts.offset; i < end; ++i)
+    {
+        const struct get_problems_candidate *candidate = &g_array_index(candidates,
+                                                                       struct get_problems_candidate,
+                                                                       i);
+        log_debug("Adding entry: %s", candidate->path);
+        g_variant_builder_add(&builder, "o", candidate->path);
+    }
+
+    log_info("GetProblems: %u matching problems, returning %u",
+             candidates->len, end > opts.offset ? end - opts.offset : 0);
+
+    g_array_free(candidates, TRUE);
 
     GVariant *retval_body[1];
     retval_body[0] = g_variant_builder_end(&builder);
@@ -2080,6 +2482,105 @@ GVariant *abrt_p2_service_get_problems(AbrtP2Service *service,
 }
 
 
+GVariant *abrt_p2_service_get_problems_properties(AbrtP2Service *service,
+                uid_t caller_uid,
+                GVariant *entries,
+                GVariant *properties,
+                GError **error)
+{
+    GDBusInterfaceInfo *iface = service->pv->p2srv_p2_entry_type.iface;
+
+    /* Empty list means all properties */
+    GPtrArray *names = g_ptr_array_new();
+    GVariantIter prop_iter;
+    const gchar *prop_name;
+    g_variant_iter_init(&prop_iter, properties);
+    while (g_variant_iter_next(&prop_iter, "&s", &prop_name))
+    {
+        if (g_dbus_interface_info_lookup_property(iface, prop_name) == NULL)
+        {
+            g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                        "Unknown property '%s'", prop_name);
+            g_ptr_array_free(names, TRUE);
+            return NULL;
+        }
+
+        g_ptr_array_add(names, (gpointer)prop_name);
+    }
+
+    if (names->len == 0)
+    {
+        for (GDBusPropertyInfo **prop = iface->properties; *prop != NULL; ++prop)
+            g_ptr_array_add(names, (*prop)->name);
+    }
+
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{oa{sv}}"));
+
+    GVariantIter entry_iter;
+    const gchar *entry_path;
+    g_variant_iter_init(&entry_iter, entries);
+    while (g_variant_iter_next(&entry_iter, "&o", &entry_path))
+    {
+        /* Omit problems the caller cannot see instead of failing the batch */
+        AbrtP2Object *obj = abrt_p2_service_get_entry_object(service,
+                                                             entry_path,
+                                                             ABRT_P2_SERVICE_ENTRY_LOOKUP_OPTIONAL,
+                                                             NULL);
+        if (obj == NULL)
+        {
+            log_debug("Entry does not exist: %s", entry_path);
+            continue;
+        }
+
+        AbrtP2Entry *entry = abrt_p2_object_get_node(obj);
+        if (abrt_p2_entry_state(entry) == ABRT_P2_ENTRY_STATE_DELETED
+            || 0 != abrt_p2_entry_accessible_by_uid(entry, caller_uid, NULL))
+        {
+            log_debug("Entry not accessible: %s", entry_path);
+            continue;
+        }
+
+        GVariantBuilder values_builder;
+        g_variant_builder_init(&values_builder, G_VARIANT_TYPE("a{sv}"));
+
+        struct dump_dir *dd = NULL;
+        for (guint i = 0; i < names->len; ++i)
+        {
+            const gchar *name = g_ptr_array_index(names, i);
+
+            GError *local_error = NULL;
+            GVariant *value = entry_object_get_property_value(entry,
+                                                              iface,
+                                                              caller_uid,
+                                                              name,
+                                                              &dd,
+                                                              &local_error);
+            if (value == NULL)
+            {
+                log_debug("Cannot get property %s of %s: %s",
+                          name, entry_path, local_error->message);
+                g_error_free(local_error);
+                continue;
+            }
+
+            g_variant_builder_add(&values_builder, "{sv}", name, value);
+            g_variant_unref(value);
+        }
+
+        if (dd != NULL)
+            dd_close(dd);
+
+        g_variant_builder_add(&builder, "{oa{sv}}", entry_path, &values_builder);
+    }
+
+    g_ptr_array_free(names, TRUE);
+
+    GVariant *retval_body[1];
+    retval_body[0] = g_variant_builder_end(&builder);
+    return g_variant_new_tuple(retval_body, ARRAY_SIZE(retval_body));
+}
+
 GVariant *abrt_p2_service_delete_problems(AbrtP2Service *service,
                 GVariant *entries,
                 uid_t caller_uid,
@@ -2181,6 +2682,20 @@ static void p2_object_dbus_method_call(GDBusConnection *connection,
         g_variant_unref(options_param);
         g_variant_unref(flags_param);
     }
+    else if (strcmp("GetProblemsProperties", method_name) == 0)
+    {
+        GVariant *entries_param = g_variant_get_child_value(parameters, 0);
+        GVariant *properties_param = g_variant_get_child_value(parameters, 1);
+
+        response = abrt_p2_service_get_problems_properties(service,
+                                                           caller_uid,
+                                                           entries_param,
+                                                           properties_param,
+                                                           &error);
+
+        g_variant_unref(properties_param);
+        g_variant_unref(entries_param);
+    }
     else if (strcmp("GetProblemData", method_name) == 0)
     {
         /* Parameter tuple is (0) */
@@ -2458,19 +2973,102 @@ static GDBusConnection *abrt_p2_service_dbus(AbrtP2Service *service)
     return service->pv->p2srv_dbus;
 }
 
-struct bridge_call_args
+/*
+ * abrt-dbus is D-Bus activated and opening and locking every directory in
+ * the dump location made each activation slow.
+ *
+ * A directory with an up to date record in the problem info cache was read
+ * without locking and none of its cached elements was modified for a while,
+ * so it is a complete problem directory and it is registered after a single
+ * stat(). dd_get_owner() returns the owner of the directory, hence the owner
+ * is taken from that stat() too. Only directories which cannot be cached yet,
+ * e.g. those modified in the last two seconds, are opened and locked.
+ */
+
+/* Returns true if the directory is a complete problem directory */
+static bool entry_object_verify_dump_dir(const char *dirname)
 {
-    AbrtP2Service *service;
-    GError **error;
-};
+    struct dump_dir *dd = dd_opendir(dirname,   DD_OPEN_FD_ONLY
+                                              | DD_FAIL_QUIETLY_ENOENT
+                                              | DD_FAIL_QUIETLY_EACCES);
+    if (dd == NULL)
+        return false;
+
+    /* Silently skip directories being created and broken directories in the
+     * silent log level, for_each_problem_in_dir() does the same. */
+    const int sv_logmode = logmode;
+    logmode = g_verbose == 0 ? 0 : sv_logmode;
+    dd = dd_fdopendir(dd, DD_OPEN_READONLY | DD_DONT_WAIT_FOR_LOCK);
+    logmode = sv_logmode;
 
-static int bridge_register_dump_dir_entry_node(struct dump_dir *dd,
-            void *call_args)
+    if (dd == NULL)
+        return false;
+
+    dd_close(dd);
+    return true;
+}
+
+static int entry_object_register_dump_location(AbrtP2Service *service,
+            GError **error)
 {
-    struct bridge_call_args *args = call_args;
-    return NULL == entry_object_register_dump_dir(args->service,
-                                                  dd->dd_dirname,
-                                                  args->error);
+    const gint64 start = g_get_monotonic_time();
+
+    DIR *dp = opendir(g_settings_dump_location);
+    if (dp == NULL)
+        return 0;
+
+    problem_info_cache_t *cache = problem_info_cache_new(g_settings_dump_location);
+    const int sync_rc = problem_info_cache_sync(cache);
+    if (sync_rc != 0)
+        log_notice("Can't update the problem info cache: %s", strerror(-sync_rc));
+
+    unsigned registered = 0;
+    unsigned cached = 0;
+
+    int retval = 0;
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        if (dot_or_dotdot(dent->d_name))
+            continue;
+
+        if (dent->d_type != DT_UNKNOWN && dent->d_type != DT_LNK && dent->d_type != DT_DIR)
+            continue;
+
+        struct stat st;
+        if (fstatat(dirfd(dp), dent->d_name, &st, 0) != 0 || !S_ISDIR(st.st_mode))
+            continue;
+
+        char *dirname = concat_path_file(g_settings_dump_location, dent->d_name);
+
+        const problem_info_t *pi = sync_rc == 0 ? problem_info_cache_lookup(cache, dent->d_name) : NULL;
+        const char *time_str = NULL;
+        if (pi != NULL && problem_info_get_item(pi, FILENAME_TIME, &time_str) && time_str != NULL)
+            ++cached;
+        else if (!entry_object_verify_dump_dir(dirname))
+        {
+            free(dirname);
+            continue;
+        }
+
+        AbrtP2Object *obj = entry_object_register_dump_dir(service, dirname, st.st_uid, error);
+        free(dirname);
+        if (obj == NULL)
+        {
+            retval = -1;
+            break;
+        }
+
+        ++registered;
+    }
+    closedir(dp);
+
+    problem_info_cache_free(cache);
+
+    log_notice("Registered %u problems in %.3fs, %u of them were cached",
+               registered, (g_get_monotonic_time() - start) / 1000000.0, cached);
+
+    return retval;
 }
 
 static void on_g_signal(GDBusProxy *proxy,
@@ -2558,13 +3156,7 @@ int abrt_p2_service_register_objects(AbrtP2Service *service, GDBusConnection *co
         return -1;
     }
 
-    struct bridge_call_args args;
-    args.service = service;
-    args.error = error;
-
-    for_each_problem_in_dir(g_settings_dump_location, (uid_t)-1, bridge_register_dump_dir_entry_node, &args);
-
-    if (*args.error != NULL)
+    if (entry_object_register_dump_location(service, error) != 0)
     {
         g_prefix_error(error, "Failed to register Problems objects: ");
         return -1;
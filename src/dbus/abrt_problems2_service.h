@@ -149,6 +149,12 @@ GVariant *abrt_p2_service_get_problems(AbrtP2Service *service,
             GVariant *options,
             GError **error);
 
+GVariant *abrt_p2_service_get_problems_properties(AbrtP2Service *service,
+            uid_t caller_uid,
+            GVariant *entries,
+            GVariant *properties,
+            GError **error);
+
 GVariant *abrt_p2_service_delete_problems(AbrtP2Service *service,
             GVariant *entries,
             uid_t caller_uid,
@@ -42,8 +42,14 @@ typedef char *security_context_t;
 
 #define KERNEL_PIPE_BUFFER_SIZE 65536
 
+/* Granularity of zero detection in SparseCore mode. Core file segments are
+ * page aligned, so a page of zeros in the stream is a page of zeros in memory.
+ */
+#define SPARSE_CHUNK_SIZE 4096
+
 static int g_user_core_flags;
 static int g_need_nonrelative;
+static bool g_sparse_core;
 
 /* I want to use -Werror, but gcc-4.4 throws a curveball:
  * "warning: ignoring return value of 'ftruncate', declared with attribute warn_unused_result"
@@ -349,13 +355,184 @@ static ssize_t splice_entire_per_partes(int in_fd, int out_fd, size_t size_limit
     return bytes;
 }
 
+enum dump_core_files_ret_flags {
+    DUMP_ABRT_CORE_FAILED  = 0x0001,
+    DUMP_USER_CORE_FAILED  = 0x0100,
+};
+
+/* A destination of dump_core_files_rw() */
+struct core_file
+{
+    int    fd;
+    bool   sparse;      /* skip zero chunks, fd must be seekable */
+    size_t limit;
+    size_t size;        /* bytes consumed from the stream, including holes */
+    size_t hole;        /* length of the pending hole not followed by data yet */
+    bool   failed;
+};
+
+static bool is_zero_chunk(const char *buf, size_t size)
+{
+    return size == 0 || (buf[0] == '\0' && memcmp(buf, buf + 1, size - 1) == 0);
+}
+
+/* Writes the non-zero runs of buf to the core file and skips over chunks of
+ * zeros with lseek(), so the file system does not allocate blocks for them.
+ */
+static void core_file_write(struct core_file *sc, const char *buf, size_t size)
+{
+    if (sc->fd < 0 || sc->failed || sc->size >= sc->limit)
+        return;
+
+    if (size > sc->limit - sc->size)
+        size = sc->limit - sc->size;
+
+    if (!sc->sparse)
+    {
+        if (full_write(sc->fd, buf, size) < 0)
+            sc->failed = true;
+        else
+            sc->size += size;
+        return;
+    }
+
+    size_t ofs = 0;
+    while (ofs < size)
+    {
+        size_t chunk = size - ofs < SPARSE_CHUNK_SIZE ? size - ofs : SPARSE_CHUNK_SIZE;
+        if (is_zero_chunk(buf + ofs, chunk))
+        {
+            sc->hole += chunk;
+            ofs += chunk;
+            continue;
+        }
+
+        /* Coalesce consecutive chunks with data to a single write() */
+        size_t data_end = ofs + chunk;
+        while (data_end < size)
+        {
+            chunk = size - data_end < SPARSE_CHUNK_SIZE ? size - data_end : SPARSE_CHUNK_SIZE;
+            if (is_zero_chunk(buf + data_end, chunk))
+                break;
+            data_end += chunk;
+        }
+
+        if (sc->hole != 0)
+        {
+            if (lseek(sc->fd, sc->hole, SEEK_CUR) < 0)
+            {
+                perror_msg("Failed to skip a hole in core file");
+                sc->failed = true;
+                return;
+            }
+            sc->hole = 0;
+        }
+
+        if (full_write(sc->fd, buf + ofs, data_end - ofs) < 0)
+        {
+            sc->failed = true;
+            return;
+        }
+
+        ofs = data_end;
+    }
+
+    sc->size += size;
+}
+
+/* A trailing hole must be materialized by extending the file. */
+static void core_file_finish(struct core_file *sc)
+{
+    if (sc->fd < 0 || sc->failed || sc->hole == 0)
+        return;
+
+    if (ftruncate(sc->fd, sc->size) != 0)
+    {
+        perror_msg("Failed to extend core file by a trailing hole");
+        sc->failed = true;
+    }
+    sc->hole = 0;
+}
+
+/* Read/write creation of core files - SparseCore and CoreCompression modes
+ *
+ * Processes with huge anonymous mappings (JVMs, databases) produce cores
+ * consisting mostly of zero pages. The function reads the core from STDIN and
+ * writes it to both the ABRT core and the user core (either can be -1) while
+ * leaving holes in place of the zero pages if SparseCore is enabled. It is
+ * slower than splice() for dense cores because data must be copied to user
+ * space.
+ *
+ * The ABRT core can be a pipe to a compressor, which is not seekable, hence
+ * the abrt_core_sparse argument.
+ *
+ * On return, *abrt_limit and *user_limit hold the sizes of the written cores.
+ */
+static int dump_core_files_rw(int abrt_core_fd, bool abrt_core_sparse, size_t *abrt_limit,
+                              int user_core_fd, size_t *user_limit)
+{
+    struct core_file cores[2] = {
+        { .fd = abrt_core_fd, .sparse = abrt_core_sparse, .limit = *abrt_limit, },
+        { .fd = user_core_fd, .sparse = g_sparse_core,    .limit = *user_limit, },
+    };
+
+    char *buf = xmalloc(KERNEL_PIPE_BUFFER_SIZE);
+    int read_failed = 0;
+    for (;;)
+    {
+        if ((cores[0].fd < 0 || cores[0].failed || cores[0].size >= cores[0].limit)
+         && (cores[1].fd < 0 || cores[1].failed || cores[1].size >= cores[1].limit))
+            break;
+
+        /* full_read() keeps the chunks page aligned with the stream */
+        const ssize_t r = full_read(STDIN_FILENO, buf, KERNEL_PIPE_BUFFER_SIZE);
+        if (r < 0)
+        {
+            perror_msg("Failed to read core dump from STDIN");
+            read_failed = 1;
+            break;
+        }
+
+        if (r == 0)
+            break;
+
+        core_file_write(&cores[0], buf, r);
+        core_file_write(&cores[1], buf, r);
+    }
+    free(buf);
+
+    core_file_finish(&cores[0]);
+    core_file_finish(&cores[1]);
+
+    *abrt_limit = cores[0].size;
+    *user_limit = cores[1].size;
+
+    int ret = 0;
+    if (abrt_core_fd >= 0 && (read_failed || cores[0].failed))
+        ret |= DUMP_ABRT_CORE_FAILED;
+    if (user_core_fd >= 0 && (read_failed || cores[1].failed))
+        ret |= DUMP_USER_CORE_FAILED;
+    return ret;
+}
+
 static int create_user_core(int user_core_fd, pid_t pid, off_t ulimit_c)
 {
     int err = 1;
     if (user_core_fd >= 0)
     {
         errno = 0;
-        ssize_t core_size = splice_entire_per_partes(STDIN_FILENO, user_core_fd, ulimit_c);
+        ssize_t core_size;
+        if (g_sparse_core)
+        {
+            size_t abrt_limit = 0;
+            size_t user_limit = ulimit_c;
+            if (dump_core_files_rw(-1, false, &abrt_limit, user_core_fd, &user_limit) & DUMP_USER_CORE_FAILED)
+                core_size = -1;
+            else
+                core_size = user_limit;
+        }
+        else
+            core_size = splice_entire_per_partes(STDIN_FILENO, user_core_fd, ulimit_c);
         if (core_size < 0)
             perror_msg("Failed to create user core '%s' in '%s'", core_basename, user_pwd);
 
@@ -427,7 +604,8 @@ static bool is_user_in_allowed_group(uid_t uid, const GList *list)
     return false;
 }
 
-static int test_configuration(bool setting_SaveFullCore, bool setting_CreateCoreBacktrace)
+static int test_configuration(bool setting_SaveFullCore, bool setting_CreateCoreBacktrace,
+                              bool setting_DeferCoreBacktrace)
 {
     if (!setting_SaveFullCore && !setting_CreateCoreBacktrace)
     {
@@ -436,6 +614,9 @@ static int test_configuration(bool setting_SaveFullCore, bool setting_CreateCore
         return 1;
     }
 
+    if (!setting_SaveFullCore && setting_DeferCoreBacktrace)
+        fprintf(stderr, "SaveFullCore is disabled - core backtrace cannot be deferred\n");
+
 #ifndef ENABLE_DUMP_TIME_UNWIND
         fprintf(stderr, "SaveFullCore is disabled but dump time unwinding is not supported\n");
 #endif /*ENABLE_DUMP_TIME_UNWIND*/
@@ -565,11 +746,6 @@ static void pipe_close(int *pfds)
     pfds[0] = pfds[1] = -1;
 }
 
-enum dump_core_files_ret_flags {
-    DUMP_ABRT_CORE_FAILED  = 0x0001,
-    DUMP_USER_CORE_FAILED  = 0x0100,
-};
-
 /* Optimized creation of two core files - ABRT and CWD
  *
  * The simplest optimization is to avoid the need to copy data to user space.
@@ -689,6 +865,339 @@ static int dump_two_core_files(int abrt_core_fd, size_t *abrt_limit, int user_co
     return r;
 }
 
+/* CoreCompression - the compressors read STDIN and write STDOUT */
+static const struct core_compressor
+{
+    const char *name;
+    const char *item;
+    const char *const args[6];
+} s_core_compressors[] = {
+    { "lz4",  FILENAME_COREDUMP_LZ4, { "lz4",  "-1", "-q", "-c", NULL } },
+    { "zstd", FILENAME_COREDUMP_ZST, { "zstd", "-1", "-q", "-c", "-T0", NULL } },
+};
+
+static const struct core_compressor *find_core_compressor(const char *name)
+{
+    for (unsigned i = 0; i < ARRAY_SIZE(s_core_compressors); ++i)
+        if (strcmp(s_core_compressors[i].name, name) == 0)
+            return &s_core_compressors[i];
+    return NULL;
+}
+
+/* Starts the compressor reading the core from in_fd and writing it to out_fd.
+ *
+ * The size of the compressed core is not known in advance, so MaxCoreFileSize
+ * is enforced by RLIMIT_FSIZE of the compressor. SIGXFSZ is ignored to make
+ * writes beyond the limit fail with EFBIG instead of killing the compressor
+ * (which would make the kernel to call us again).
+ */
+static pid_t start_core_compressor(const struct core_compressor *compressor, int in_fd, int out_fd, size_t limit)
+{
+    const pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror_msg("fork");
+        return pid;
+    }
+
+    if (pid == 0)
+    {
+        if (in_fd != STDIN_FILENO)
+            xmove_fd(in_fd, STDIN_FILENO);
+        xmove_fd(out_fd, STDOUT_FILENO);
+
+        signal(SIGXFSZ, SIG_IGN);
+        if (limit != SIZE_MAX)
+        {
+            const struct rlimit rl = { limit, limit };
+            if (setrlimit(RLIMIT_FSIZE, &rl) != 0)
+                perror_msg_and_die("Can't limit size of compressed core file");
+        }
+
+        execvp(compressor->args[0], (char **)compressor->args);
+        perror_msg_and_die("Can't execute '%s'", compressor->args[0]);
+    }
+
+    return pid;
+}
+
+/* Compressed creation of core files
+ *
+ * If there is no user core, the compressor reads the kernel pipe directly.
+ * Otherwise, the core is read once and written to the user core file and to
+ * a pipe to the compressor.
+ *
+ * On return, *abrt_limit holds the size of the compressed core.
+ */
+static int dump_compressed_core_files(const struct core_compressor *compressor,
+                                      int abrt_core_fd, size_t *abrt_limit,
+                                      int user_core_fd, size_t *user_limit)
+{
+    int r = 0;
+    pid_t pid = -1;
+    if (user_core_fd < 0)
+        pid = start_core_compressor(compressor, STDIN_FILENO, abrt_core_fd, *abrt_limit);
+    else
+    {
+        /* O_CLOEXEC: the compressor must not hold the write end */
+        int pfds[2] = { -1, -1 };
+        if (pipe2(pfds, O_CLOEXEC) < 0)
+            perror_msg("Failed to create pipe for core compressor");
+        else
+        {
+            pid = start_core_compressor(compressor, pfds[0], abrt_core_fd, *abrt_limit);
+            close(pfds[0]);
+        }
+
+        /* The compressor exits early if it exceeds the limit */
+        signal(SIGPIPE, SIG_IGN);
+
+        size_t raw_limit = pid < 0 ? 0 : SIZE_MAX;
+        r = dump_core_files_rw(pid < 0 ? -1 : pfds[1], false, &raw_limit, user_core_fd, user_limit);
+        r &= ~DUMP_ABRT_CORE_FAILED;
+
+        if (pfds[1] >= 0)
+            close(pfds[1]);
+    }
+
+    if (pid < 0)
+        return r | DUMP_ABRT_CORE_FAILED;
+
+    int status;
+    if (safe_waitpid(pid, &status, 0) < 0)
+    {
+        perror_msg("waitpid");
+        return r | DUMP_ABRT_CORE_FAILED;
+    }
+
+    if (!WIFEXITED(status))
+    {
+        error_msg("Core compressor '%s' was killed by signal %d", compressor->name, WTERMSIG(status));
+        return r | DUMP_ABRT_CORE_FAILED;
+    }
+
+    if (WEXITSTATUS(status) != 0)
+        log_warning("Core compressor '%s' exited with %d, the compressed core might be truncated",
+                    compressor->name, WEXITSTATUS(status));
+
+    struct stat st;
+    if (fstat(abrt_core_fd, &st) != 0)
+    {
+        perror_msg("Can't stat compressed core file");
+        return r | DUMP_ABRT_CORE_FAILED;
+    }
+    *abrt_limit = st.st_size;
+
+    return r;
+}
+
+static unsigned long long elapsed_us(const struct timespec *since)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1000000LL
+           + (now.tv_nsec - since->tv_nsec) / 1000;
+}
+
+static unsigned long long elapsed_ms(const struct timespec *since)
+{
+    return elapsed_us(since) / 1000;
+}
+
+/* Phases of the hook, the time spent in each of them is logged and
+ * optionally appended to HookStatsFile.
+ */
+enum hook_phase
+{
+    HP_NONE = -1,
+    HP_CONFIG,
+    HP_PROC,
+    HP_DUMP_DIR,
+    HP_CORE,
+    HP_PACKAGE,
+    HP_UNWIND,
+    HP_RENAME,
+    HP_NOTIFY,
+    HP_TRIM,
+    HP_COUNT,
+};
+
+static const char *const s_hook_phase_names[HP_COUNT] = {
+    [HP_CONFIG]   = "config",
+    [HP_PROC]     = "proc",
+    [HP_DUMP_DIR] = "dump_dir",
+    [HP_CORE]     = "core",
+    [HP_PACKAGE]  = "package",
+    [HP_UNWIND]   = "unwind",
+    [HP_RENAME]   = "rename",
+    [HP_NOTIFY]   = "notify",
+    [HP_TRIM]     = "trim",
+};
+
+static unsigned long long s_hook_phase_us[HP_COUNT];
+static enum hook_phase s_hook_phase = HP_NONE;
+static struct timespec s_hook_phase_start;
+
+/* Ends the current phase and starts the given one. A phase can be entered
+ * several times, the times are summed up.
+ */
+static void hook_phase_begin(enum hook_phase phase)
+{
+    if (s_hook_phase != HP_NONE)
+        s_hook_phase_us[s_hook_phase] += elapsed_us(&s_hook_phase_start);
+
+    s_hook_phase = phase;
+    clock_gettime(CLOCK_MONOTONIC, &s_hook_phase_start);
+}
+
+static void report_hook_phases(const char *stats_file, pid_t pid, const char *executable, size_t core_size)
+{
+    hook_phase_begin(HP_NONE);
+
+    unsigned long long total_us = 0;
+    struct strbuf *line = strbuf_new();
+    for (unsigned i = 0; i < HP_COUNT; ++i)
+    {
+        strbuf_append_strf(line, "%s_us=%llu ", s_hook_phase_names[i], s_hook_phase_us[i]);
+        total_us += s_hook_phase_us[i];
+    }
+
+    /* Throughput of core streaming in MB/s (bytes per microsecond) */
+    const double core_mbps = s_hook_phase_us[HP_CORE] ? (double)core_size / s_hook_phase_us[HP_CORE] : 0;
+    strbuf_append_strf(line, "total_us=%llu core_bytes=%zu core_MBps=%.1f pid=%lu executable=%s",
+                       total_us, core_size, core_mbps, (long)pid, executable);
+
+    log_notice("Hook phases: %s", line->buf);
+
+    if (stats_file != NULL)
+    {
+        /* One write() per line, so concurrent hooks do not mix their lines */
+        strbuf_append_char(line, '\n');
+        const int fd = open(stats_file, O_WRONLY | O_APPEND | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
+        if (fd < 0)
+            perror_msg("Can't open '%s'", stats_file);
+        else
+        {
+            if (full_write(fd, line->buf, line->len) < 0)
+                perror_msg("Can't write to '%s'", stats_file);
+            close(fd);
+        }
+    }
+
+    strbuf_free(line);
+}
+
+/* Files from /proc/[pid] copied to the dump directory as they are */
+static const struct proc_item
+{
+    const char *item;
+    const char *proc_name;
+} s_proc_items[] = {
+    // Disabled for now: /proc/PID/smaps tends to be BIG,
+    // and not much more informative than /proc/PID/maps:
+    // { FILENAME_SMAPS, "smaps" },
+    { FILENAME_MAPS, "maps" },
+    { FILENAME_LIMITS, "limits" },
+    { FILENAME_CGROUP, "cgroup" },
+    { FILENAME_MOUNTINFO, "mountinfo" },
+};
+
+#define PROC_ITEMS_ARENA_SIZE (64 * 1024)
+
+/* Reads all s_proc_items into a single buffer first and writes them to the
+ * dump directory afterwards. The files are generated by the kernel while
+ * being read, so reading them in one go gives a more consistent picture of
+ * the process and the time spent on each of them is logged.
+ */
+static void save_proc_items_at(struct dump_dir *dd, int pid_proc_fd)
+{
+    struct
+    {
+        size_t offset;
+        size_t size;
+        unsigned long long read_us;
+        bool ok;
+    } collected[ARRAY_SIZE(s_proc_items)];
+
+    size_t arena_size = PROC_ITEMS_ARENA_SIZE;
+    char *arena = xmalloc(arena_size);
+    size_t used = 0;
+
+    for (unsigned i = 0; i < ARRAY_SIZE(s_proc_items); ++i)
+    {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        collected[i].offset = used;
+        collected[i].ok = false;
+
+        const int fd = openat(pid_proc_fd, s_proc_items[i].proc_name, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            log_notice("Can't open /proc/[pid]/%s: %s", s_proc_items[i].proc_name, strerror(errno));
+            collected[i].size = 0;
+            continue;
+        }
+
+        for (;;)
+        {
+            if (used == arena_size)
+            {
+                arena_size *= 2;
+                arena = xrealloc(arena, arena_size);
+            }
+
+            const ssize_t r = safe_read(fd, arena + used, arena_size - used);
+            if (r < 0)
+            {
+                perror_msg("Can't read /proc/[pid]/%s", s_proc_items[i].proc_name);
+                break;
+            }
+            if (r == 0)
+            {
+                collected[i].ok = true;
+                break;
+            }
+            used += r;
+        }
+        close(fd);
+
+        collected[i].size = used - collected[i].offset;
+        collected[i].read_us = elapsed_us(&start);
+    }
+
+    for (unsigned i = 0; i < ARRAY_SIZE(s_proc_items); ++i)
+    {
+        if (!collected[i].ok)
+            continue;
+
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        const int fd = dd_open_item(dd, s_proc_items[i].item, O_RDWR);
+        if (fd < 0)
+        {
+            perror_msg("Can't create %s", s_proc_items[i].item);
+            continue;
+        }
+
+        if (full_write(fd, arena + collected[i].offset, collected[i].size) < 0)
+        {
+            perror_msg("Can't write %s", s_proc_items[i].item);
+            close(fd);
+            dd_delete_item(dd, s_proc_items[i].item);
+            continue;
+        }
+        close(fd);
+
+        log_notice("Saved %s: %zu bytes, read in %llu us, written in %llu us",
+                   s_proc_items[i].item, collected[i].size,
+                   collected[i].read_us, elapsed_us(&start));
+    }
+
+    free(arena);
+}
+
 enum create_core_backtrace_status
 {
     CB_DISABLED     = 0x1,
@@ -839,6 +1348,11 @@ int main(int argc, char** argv)
     if (fd > 2)
         close(fd);
 
+    /* The kernel holds the crashed process until we close STDIN */
+    struct timespec hook_start;
+    clock_gettime(CLOCK_MONOTONIC, &hook_start);
+    hook_phase_begin(HP_CONFIG);
+
     int err = 1;
     logmode = LOGMODE_JOURNAL;
 
@@ -859,9 +1373,14 @@ int main(int argc, char** argv)
     bool setting_SaveBinaryImage;
     bool setting_SaveFullCore;
     bool setting_CreateCoreBacktrace;
+    bool setting_DeferCoreBacktrace;
     bool setting_SaveContainerizedPackageData;
     bool setting_StandaloneHook;
     unsigned int setting_MaxCoreFileSize = g_settings_nMaxCrashReportsSize;
+    const struct core_compressor *setting_CoreCompression = NULL;
+    unsigned int setting_CrashStormLimit = 0;
+    unsigned int setting_CrashStormWindow = 60;
+    char *setting_HookStatsFile = NULL;
 
     GList *setting_ignored_paths = NULL;
     GList *setting_allowed_users = NULL;
@@ -878,6 +1397,8 @@ int main(int argc, char** argv)
         setting_SaveFullCore = value ? string_to_bool(value) : true;
         value = get_map_string_item_or_NULL(settings, "CreateCoreBacktrace");
         setting_CreateCoreBacktrace = value ? string_to_bool(value) : true;
+        value = get_map_string_item_or_NULL(settings, "DeferCoreBacktrace");
+        setting_DeferCoreBacktrace = value && string_to_bool(value);
         value = get_map_string_item_or_NULL(settings, "IgnoredPaths");
         if (value)
             setting_ignored_paths = parse_list(value);
@@ -893,6 +1414,29 @@ int main(int argc, char** argv)
         if (value && !try_get_map_string_item_as_uint(settings, "MaxCoreFileSize", &setting_MaxCoreFileSize))
             log_warning("The MaxCoreFileSize option in the CCpp.conf file holds an invalid value");
 
+        value = get_map_string_item_or_NULL(settings, "SparseCore");
+        g_sparse_core = value && string_to_bool(value);
+
+        value = get_map_string_item_or_NULL(settings, "CoreCompression");
+        if (value && value[0] != '\0' && strcmp(value, "none") != 0)
+        {
+            setting_CoreCompression = find_core_compressor(value);
+            if (setting_CoreCompression == NULL)
+                log_warning("The CoreCompression option in the CCpp.conf file holds an unsupported value '%s'", value);
+        }
+
+        value = get_map_string_item_or_NULL(settings, "CrashStormLimit");
+        if (value && !try_get_map_string_item_as_uint(settings, "CrashStormLimit", &setting_CrashStormLimit))
+            log_warning("The CrashStormLimit option in the CCpp.conf file holds an invalid value");
+
+        value = get_map_string_item_or_NULL(settings, "CrashStormWindow");
+        if (value && !try_get_map_string_item_as_uint(settings, "CrashStormWindow", &setting_CrashStormWindow))
+            log_warning("The CrashStormWindow option in the CCpp.conf file holds an invalid value");
+
+        value = get_map_string_item_or_NULL(settings, "HookStatsFile");
+        if (value && value[0] != '\0')
+            setting_HookStatsFile = xstrdup(value);
+
         value = get_map_string_item_or_NULL(settings, "SaveContainerizedPackageData");
         setting_SaveContainerizedPackageData = value && string_to_bool(value);
 
@@ -913,7 +1457,8 @@ int main(int argc, char** argv)
     }
 
     if (argc == 2 && !strcmp(argv[1], "--test-config"))
-        return test_configuration(setting_SaveFullCore, setting_CreateCoreBacktrace);
+        return test_configuration(setting_SaveFullCore, setting_CreateCoreBacktrace,
+                                  setting_DeferCoreBacktrace);
 
     if (argc < 8)
     {
@@ -922,6 +1467,8 @@ int main(int argc, char** argv)
         error_msg_and_die("Usage: %s SIGNO CORE_SIZE_LIMIT PID UID GID TIME GLOBAL_PID GLOBAL_TID", argv[0]);
     }
 
+    hook_phase_begin(HP_PROC);
+
     /* Not needed on 2.6.30.
      * At least 2.6.18 has a bug where
      * argv[1] = "SIGNO CORE_SIZE_LIMIT PID ..."
@@ -1073,6 +1620,24 @@ int main(int argc, char** argv)
         /* It is a repeating crash */
         return create_user_core(user_core_fd, pid, ulimit_c);
     }
+    /* Crash storm admission control: do not let a crash looping executable
+     * saturate the disk with identical cores.
+     */
+    if (setting_CrashStormLimit > 0)
+    {
+        unsigned suppressed = 0;
+        snprintf(path, sizeof(path), "%s/last-ccpp-rate", g_settings_dump_location);
+        if (check_crash_rate_file(path, executable, setting_CrashStormLimit, setting_CrashStormWindow, &suppressed))
+        {
+            error_msg_ignore_crash(pid_str, last_slash, (long unsigned)uid, signal_no,
+                    signame, "crash storm, %u crashes throttled", suppressed);
+
+            return create_user_core(user_core_fd, pid, ulimit_c);
+        }
+
+        if (suppressed > 0)
+            log_warning("%u crashes of %s were throttled by 'CrashStormLimit'", suppressed, executable);
+    }
     const bool abrt_crash = (last_slash && (strncmp(last_slash, "abrt", 4) == 0));
     if (abrt_crash && g_settings_debug_level == 0)
     {
@@ -1155,7 +1720,7 @@ int main(int argc, char** argv)
 
     unsigned path_len = snprintf(path, sizeof(path), "%s/ccpp-%s-%lu.new",
             g_settings_dump_location, iso_date_string(NULL), (long)pid);
-    if (path_len >= (sizeof(path) - sizeof("/"FILENAME_COREDUMP)))
+    if (path_len >= (sizeof(path) - sizeof("/"FILENAME_COREDUMP_ZST)))
     {
         return create_user_core(user_core_fd, pid, ulimit_c);
     }
@@ -1170,6 +1735,7 @@ int main(int argc, char** argv)
      *   the directory until the hook is done (avoid race conditions and defend
      *   hard and symbolic link attacs)
      */
+    hook_phase_begin(HP_DUMP_DIR);
     dd = dd_create(path, /*fs owner*/0, DEFAULT_DUMP_DIR_MODE);
     if (dd)
     {
@@ -1193,15 +1759,11 @@ int main(int argc, char** argv)
             dd_create_basic_files(dd, fsuid, NULL);
         }
 
-        // Disabled for now: /proc/PID/smaps tends to be BIG,
-        // and not much more informative than /proc/PID/maps:
-        // dd_copy_file_at(dd, FILENAME_SMAPS, pid_proc_fd, "smaps");
-
-        dd_copy_file_at(dd, FILENAME_MAPS, pid_proc_fd, "maps");
-        dd_copy_file_at(dd, FILENAME_LIMITS, pid_proc_fd, "limits");
-        dd_copy_file_at(dd, FILENAME_CGROUP, pid_proc_fd, "cgroup");
-        dd_copy_file_at(dd, FILENAME_MOUNTINFO, pid_proc_fd, "mountinfo");
+        hook_phase_begin(HP_PROC);
+        save_proc_items_at(dd, pid_proc_fd);
 
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
         FILE *open_fds = dd_open_item_file(dd, FILENAME_OPEN_FDS, O_RDWR);
         if (open_fds != NULL)
         {
@@ -1209,7 +1771,9 @@ int main(int argc, char** argv)
                 dd_delete_item(dd, FILENAME_OPEN_FDS);
             fclose(open_fds);
         }
+        log_notice("Saved %s in %llu us", FILENAME_OPEN_FDS, elapsed_us(&start));
 
+        clock_gettime(CLOCK_MONOTONIC, &start);
         const int init_proc_dir_fd = open_proc_pid_dir(1);
         FILE *namespaces = dd_open_item_file(dd, FILENAME_NAMESPACES, O_RDWR);
         if (namespaces != NULL && init_proc_dir_fd >= 0)
@@ -1221,6 +1785,7 @@ int main(int argc, char** argv)
             close(init_proc_dir_fd);
         if (namespaces != NULL)
             fclose(namespaces);
+        log_notice("Saved %s in %llu us", FILENAME_NAMESPACES, elapsed_us(&start));
 
         /* There's no need to compare mount namespaces and search for '/' in
          * mountifo.  Comparison of inodes of '/proc/[pid]/root' and '/' works
@@ -1312,10 +1877,12 @@ int main(int argc, char** argv)
             }
         }
 
+        hook_phase_begin(HP_CORE);
         size_t core_size = 0;
         if (setting_SaveFullCore)
         {
-            int abrt_core_fd = dd_open_item(dd, FILENAME_COREDUMP, O_RDWR);
+            const char *core_item = setting_CoreCompression ? setting_CoreCompression->item : FILENAME_COREDUMP;
+            int abrt_core_fd = dd_open_item(dd, core_item, O_RDWR);
             if (abrt_core_fd < 0)
             {   /* Avoid the need to deal with two destinations. */
                 perror_msg("Failed to create ABRT core file in '%s'", dd->dd_dirname);
@@ -1345,7 +1912,34 @@ int main(int argc, char** argv)
                 else
                     abrt_limit = SIZE_MAX;
 
-                if (user_core_fd < 0)
+                if (setting_CoreCompression)
+                {
+                    size_t user_limit = user_core_fd < 0 ? 0 : ulimit_c;
+                    const int r = dump_compressed_core_files(setting_CoreCompression, abrt_core_fd, &abrt_limit,
+                                                             user_core_fd, &user_limit);
+
+                    if (user_core_fd >= 0)
+                        close_user_core(user_core_fd, (r & DUMP_USER_CORE_FAILED) ? -1 : user_limit);
+
+                    if (r & DUMP_ABRT_CORE_FAILED)
+                        error_msg("Failed to write compressed ABRT core file");
+                    else
+                        core_size = abrt_limit;
+                }
+                else if (g_sparse_core)
+                {
+                    size_t user_limit = user_core_fd < 0 ? 0 : ulimit_c;
+                    const int r = dump_core_files_rw(abrt_core_fd, true, &abrt_limit, user_core_fd, &user_limit);
+
+                    if (user_core_fd >= 0)
+                        close_user_core(user_core_fd, (r & DUMP_USER_CORE_FAILED) ? -1 : user_limit);
+
+                    if (r & DUMP_ABRT_CORE_FAILED)
+                        perror_msg("Failed to write ABRT core file");
+                    else
+                        core_size = abrt_limit;
+                }
+                else if (user_core_fd < 0)
                 {
                     const ssize_t r = splice_entire_per_partes(STDIN_FILENO, abrt_core_fd, abrt_limit);
                     if (r < 0)
@@ -1418,6 +2012,7 @@ int main(int argc, char** argv)
         }
 #endif
 
+        hook_phase_begin(HP_PACKAGE);
         if (abrtd_running && setting_SaveContainerizedPackageData && containerized)
         {   /* Do we really need to run rpm from core_pattern hook? */
             sprintf(source_filename, "/proc/%lu/root", (long)pid);
@@ -1435,20 +2030,38 @@ int main(int argc, char** argv)
             safe_waitpid(pid, &stat, 0);
         }
 
+        hook_phase_begin(HP_UNWIND);
         enum create_core_backtrace_status cbr = 0;
         /* Perform crash-time unwind of the guilty thread. */
         if (tid > 0 && setting_CreateCoreBacktrace)
         {
-            log_debug("Creating core_backtrace\n");
-            cbr = create_core_backtrace(dd, uid, fsuid, gid, fsgid, tid, executable, signal_no);
-            if (cbr & CB_DISABLED)
-                log_warning("CreateCoreBacktrace is enabled but dump time unwinding is not supported");
+            /* The saved core contains everything the unwinder needs, so the
+             * post-create event can generate core_backtrace from it
+             * after the crashed process is released. */
+            if (setting_DeferCoreBacktrace && core_size > 0)
+                log_info("Deferring core_backtrace generation to post-create event");
+            else
+            {
+                log_debug("Creating core_backtrace\n");
+                struct timespec unwind_start;
+                clock_gettime(CLOCK_MONOTONIC, &unwind_start);
+                cbr = create_core_backtrace(dd, uid, fsuid, gid, fsgid, tid, executable, signal_no);
+                if (cbr & CB_DISABLED)
+                    log_warning("CreateCoreBacktrace is enabled but dump time unwinding is not supported");
+                else
+                    log_notice("Dump time unwinding took %llu ms", elapsed_ms(&unwind_start));
+            }
         }
 
         /* Make sure we closed STDIN_FILENO to let kernel to wipe out the process. */
         if (!(cbr & CB_STDIN_CLOSED))
             close(STDIN_FILENO);
 
+        log_notice("Released crashed process %lu after %llu ms",
+                   (long)pid, elapsed_ms(&hook_start));
+
+        hook_phase_begin(HP_RENAME);
+
         /* We close dumpdir before we start catering for crash storm case.
          * Otherwise, delete_dump_dir's from other concurrent
          * CCpp's won't be able to delete our dump (their delete_dump_dir
@@ -1469,10 +2082,12 @@ int main(int argc, char** argv)
             log_notice("Saved core dump of pid %lu (%s) to %s (%zu bytes)",
                        (long)pid, executable, path, core_size);
 
+        hook_phase_begin(HP_NOTIFY);
         if (abrtd_running)
             notify_new_path(path);
 
         /* rhbz#539551: "abrt going crazy when crashing process is respawned" */
+        hook_phase_begin(HP_TRIM);
         if (g_settings_nMaxCrashReportsSize > 0)
         {
             /* x1.25 and round up to 64m: go a bit up, so that usual in-daemon trimming
@@ -1483,6 +2098,8 @@ int main(int argc, char** argv)
             trim_problem_dirs(g_settings_dump_location, maxsize * (double)(1024*1024), path);
         }
 
+        report_hook_phases(setting_HookStatsFile, pid, executable, core_size);
+
         err = 0;
     }
     else
@@ -20,6 +20,12 @@
 #undef ARRAY_SIZE
 #define ARRAY_SIZE(x) ((unsigned)(sizeof(x) / sizeof((x)[0])))
 
+/* Names of compressed core dumps (see CoreCompression and
+ * SystemdCoredumpAdoption in CCpp.conf) */
+#define FILENAME_COREDUMP_LZ4 FILENAME_COREDUMP".lz4"
+#define FILENAME_COREDUMP_ZST FILENAME_COREDUMP".zst"
+#define FILENAME_COREDUMP_XZ  FILENAME_COREDUMP".xz"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -40,6 +46,31 @@ int vdprintf(int d, const char *format, va_list ap);
 */
 int low_free_space(unsigned setting_MaxCrashReportsSize, const char *dump_location);
 
+/**
+  @brief Size of a problem directory and its weight for deletion
+*/
+struct dir_size
+{
+    double size;
+    double weight;  /* size in KiB multiplied by age in minutes */
+    char name[];
+};
+
+/**
+  @brief Computes size of a dump location and sorts its sub-directories
+
+  The sizes of sub-directories are cached in the dump location, hence only the
+  directories modified since the last call are traversed.
+
+  @param dirname Path to a dump location
+  @param worst_dirs If not NULL, a list of malloced struct dir_size sorted
+         by weight, the heaviest first
+  @param excluded Name of a sub-directory that is not included in worst_dirs
+  @return Size of the dump location in Bytes
+*/
+#define get_dirsize_find_worst_dirs abrt_get_dirsize_find_worst_dirs
+double get_dirsize_find_worst_dirs(const char *dirname, GList **worst_dirs, const char *excluded);
+
 #define trim_problem_dirs abrt_trim_problem_dirs
 void trim_problem_dirs(const char *dirname, double cap_size, const char *exclude_path);
 #define ensure_writable_dir_id abrt_ensure_writable_dir_uid_git
@@ -48,6 +79,31 @@ void ensure_writable_dir_uid_gid(const char *dir, mode_t mode, uid_t uid, gid_t
 void ensure_writable_dir(const char *dir, mode_t mode, const char *user);
 #define ensure_writable_dir_group abrt_ensure_writable_dir_group
 void ensure_writable_dir_group(const char *dir, mode_t mode, const char *user, const char *group);
+
+/**
+  @brief Decompresses a compressed core dump next to the compressed one
+
+  Tools reading the core dump must call this function because abrt-hook-ccpp
+  and abrt-dump-journal-core can store the core dump compressed. The
+  compressed core dump is kept and the raw one must be removed by
+  remove_unpacked_coredump() once the tool does not need it.
+
+  @param dump_dir_name Path to a problem directory
+  @return 1 if the raw core dump was decompressed; 0 if the problem directory
+  already contains the raw core dump; otherwise -1
+*/
+#define unpack_compressed_coredump abrt_unpack_compressed_coredump
+int unpack_compressed_coredump(const char *dump_dir_name);
+
+/**
+  @brief Removes the raw core dump decompressed by unpack_compressed_coredump()
+
+  @param dump_dir_name Path to a problem directory
+  @param unpacked The value returned by unpack_compressed_coredump(), nothing
+  is removed unless it is 1
+*/
+#define remove_unpacked_coredump abrt_remove_unpacked_coredump
+void remove_unpacked_coredump(const char *dump_dir_name, int unpacked);
 #define run_unstrip_n abrt_run_unstrip_n
 char *run_unstrip_n(const char *dump_dir_name, unsigned timeout_sec);
 #define get_backtrace abrt_get_backtrace
@@ -83,12 +139,18 @@ extern bool          g_settings_shortenedreporting;
 extern bool          g_settings_explorechroots;
 #define g_settings_debug_level abrt_g_settings_debug_level
 extern unsigned int  g_settings_debug_level;
+#define g_settings_nMaxPostCreateProcesses abrt_g_settings_nMaxPostCreateProcesses
+extern unsigned int  g_settings_nMaxPostCreateProcesses;
 
 
 #define load_abrt_conf abrt_load_abrt_conf
 int load_abrt_conf(void);
 #define free_abrt_conf_data abrt_free_abrt_conf_data
 void free_abrt_conf_data(void);
+/* Calls load_abrt_conf() only if abrt.conf was modified since the last call
+ * or the configuration was freed */
+#define load_abrt_conf_if_changed abrt_load_abrt_conf_if_changed
+int load_abrt_conf_if_changed(void);
 
 #define load_abrt_conf_file abrt_load_abrt_conf_file
 int load_abrt_conf_file(const char *file, map_string_t *settings);
@@ -107,6 +169,66 @@ void migrate_to_xdg_dirs(void);
 
 int check_recent_crash_file(const char *filename, const char *executable);
 
+/**
+  @brief Checks whether the executable crashes more often than allowed
+
+  Implements a token bucket per executable allowing max_crashes crashes per
+  window_sec seconds. The state of the buckets is stored in the file.
+
+  @param filename Path to the file holding the state of token buckets
+  @param executable Path to the crashed executable
+  @param max_crashes Maximal number of crashes per window; 0 disables the check
+  @param window_sec Length of the window in seconds
+  @param suppressed Number of crashes throttled since the last allowed crash
+  @return 1 if the crash should be throttled; otherwise 0
+*/
+#define check_crash_rate_file abrt_check_crash_rate_file
+int check_crash_rate_file(const char *filename, const char *executable,
+                unsigned max_crashes, unsigned window_sec, unsigned *suppressed);
+
+/**
+  @brief Token bucket of an executable, see check_crash_rate_file()
+*/
+struct abrt_crash_rate_bucket
+{
+    double tokens;
+    long long last_update;
+    unsigned suppressed;
+};
+
+/**
+  @brief Initializes a full bucket allowing max_crashes crashes
+*/
+#define crash_rate_bucket_init abrt_crash_rate_bucket_init
+void crash_rate_bucket_init(struct abrt_crash_rate_bucket *bucket, unsigned max_crashes, long long now);
+
+/**
+  @brief Refills the bucket and takes a token for a crash at the time now
+
+  @param suppressed Number of crashes throttled since the last allowed crash
+  @return 1 if the bucket is empty and the crash should be throttled; otherwise 0
+*/
+#define crash_rate_bucket_take abrt_crash_rate_bucket_take
+int crash_rate_bucket_take(struct abrt_crash_rate_bucket *bucket, unsigned max_crashes,
+                unsigned window_sec, long long now, unsigned *suppressed);
+
+/**
+  @brief Reads the next entry of a crash rate file
+
+  Malformed lines are skipped.
+
+  @param filename Name of the file used in messages
+  @return Malloced executable or NULL at the end of the file
+*/
+#define crash_rate_read_entry abrt_crash_rate_read_entry
+char *crash_rate_read_entry(FILE *fp, const char *filename, struct abrt_crash_rate_bucket *bucket);
+
+/**
+  @brief Writes an entry of a crash rate file
+*/
+#define crash_rate_write_entry abrt_crash_rate_write_entry
+void crash_rate_write_entry(FILE *fp, const char *executable, const struct abrt_crash_rate_bucket *bucket);
+
 /* Returns 1 if abrtd daemon is running, 0 otherwise. */
 #define daemon_is_ok abrt_daemon_is_ok
 int daemon_is_ok(void);
@@ -160,6 +282,20 @@ struct abrt_koops_line_info {
 void koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_line_info *lines_info, int lines_info_size);
 #define koops_extract_oopses abrt_koops_extract_oopses
 void koops_extract_oopses(GList **oops_list, char *buffer, size_t buflen);
+/**
+ * Extracts oopses from a chunk of a log which continues in the next chunk.
+ *
+ * Only complete lines are processed and oopses which might continue in the
+ * next chunk are not extracted. The unprocessed rest of the chunk must be
+ * passed again at the beginning of the next chunk.
+ *
+ * If last_chunk is true, the chunk ends at the current end of the log and
+ * only an oops which has not ended yet is left unprocessed.
+ *
+ * @returns the number of processed bytes at the beginning of the buffer
+ */
+#define koops_extract_oopses_from_chunk abrt_koops_extract_oopses_from_chunk
+size_t koops_extract_oopses_from_chunk(GList **oops_list, char *buffer, size_t buflen, bool last_chunk);
 #define koops_suspicious_strings_list abrt_koops_suspicious_strings_list
 GList *koops_suspicious_strings_list(void);
 #define koops_print_suspicious_strings abrt_koops_print_suspicious_strings
@@ -173,6 +309,42 @@ void koops_print_suspicious_strings(void);
 #define koops_print_suspicious_strings_filtered abrt_koops_print_suspicious_strings_filtered
 void koops_print_suspicious_strings_filtered(const regex_t **filterout);
 
+/**
+  @struct strings_matcher
+  @brief An opaque structure finding any of a set of strings in a text in
+  a single pass over the text
+*/
+typedef struct strings_matcher strings_matcher_t;
+
+/**
+  @brief Compiles the strings into a new instance of strings matcher
+
+  @param strings A list of strings, the strings are copied
+  @return An instance which must be destroyed by strings_matcher_free()
+*/
+#define strings_matcher_new abrt_strings_matcher_new
+strings_matcher_t *strings_matcher_new(GList *strings);
+
+/**
+  @brief Destroys an instance of strings matcher
+
+  @param matcher A destroyed instance, can be NULL
+*/
+#define strings_matcher_free abrt_strings_matcher_free
+void strings_matcher_free(strings_matcher_t *matcher);
+
+/**
+  @brief Finds any of the strings in a text, the same as calling strstr() for
+  every string
+
+  @param matcher An instance of strings matcher
+  @param text A searched text
+  @return NULL if the text does not contain any of the strings; otherwise one
+  of the found strings
+*/
+#define strings_matcher_find abrt_strings_matcher_find
+const char *strings_matcher_find(const strings_matcher_t *matcher, const char *text);
+
 /* dbus client api */
 
 /**
@@ -340,6 +512,127 @@ void ignored_problems_remove_problem_data(ignored_problems_t *set, problem_data_
 */
 bool ignored_problems_contains_problem_data(ignored_problems_t *set, problem_data_t *pd);
 
+/**
+  @struct problem_info_cache
+  @brief An opaque structure holding elements of problems in a dump location
+  needed for listing the problems
+
+  The cache is persisted in a file in the dump location. Only processes
+  allowed to write to the dump location can update the file.
+*/
+typedef struct problem_info_cache problem_info_cache_t;
+
+/**
+  @struct problem_info
+  @brief An opaque structure holding the cached elements of a problem
+*/
+typedef struct problem_info problem_info_t;
+
+/**
+  @brief Initializes a new instance of problem info cache
+
+  @param dump_location A path to the dump location
+  @return An instance which must be destroyed by problem_info_cache_free()
+*/
+#define problem_info_cache_new abrt_problem_info_cache_new
+problem_info_cache_t *problem_info_cache_new(const char *dump_location);
+
+/**
+  @brief Destroys an instance of problem info cache
+
+  @param cache A destroyed instance, can be NULL
+*/
+#define problem_info_cache_free abrt_problem_info_cache_free
+void problem_info_cache_free(problem_info_cache_t *cache);
+
+/**
+  @brief Finds up to date cached elements of a problem
+
+  @param cache An instance of problem info cache
+  @param problem_dir Either a name of the problem directory or its full path
+  @return NULL if the problem is not cached or the cached elements are out of
+  date; otherwise the cached elements valid until the next call on the cache
+*/
+#define problem_info_cache_lookup abrt_problem_info_cache_lookup
+const problem_info_t *problem_info_cache_lookup(problem_info_cache_t *cache, const char *problem_dir);
+
+/**
+  @brief Gets a cached element
+
+  @param pi Cached elements of a problem
+  @param element A name of the element
+  @param value Set to the element's value or to NULL if the problem does not
+  have the element
+  @return false if the element is not cached; otherwise true
+*/
+#define problem_info_get_item abrt_problem_info_get_item
+bool problem_info_get_item(const problem_info_t *pi, const char *element, const char **value);
+
+/**
+  @brief Brings the cache up to date with the dump location
+
+  Reads elements of new and modified problems, forgets deleted problems and
+  saves the cache if anything has changed.
+
+  @param cache An instance of problem info cache
+  @return 0 on success; otherwise a negative errno
+*/
+#define problem_info_cache_sync abrt_problem_info_cache_sync
+int problem_info_cache_sync(problem_info_cache_t *cache);
+
+/**
+  @brief Gets a value attached to a problem by problem_info_cache_annotate()
+
+  @param cache An instance of problem info cache
+  @param problem_dir Either a name of the problem directory or its full path
+  @param name A name of the annotation
+  @return NULL if the problem has no such annotation; otherwise the value
+  valid until the next call on the cache
+*/
+#define problem_info_cache_get_annotation abrt_problem_info_cache_get_annotation
+const char *problem_info_cache_get_annotation(problem_info_cache_t *cache, const char *problem_dir,
+                const char *name);
+
+/**
+  @brief Attaches a value which is not a problem element to a problem
+
+  Annotations are stored only in the cache, hence they are never reported.
+  They are kept until the problem is deleted, modifications of the problem
+  do not affect them. The cache is saved immediately.
+
+  @param cache An instance of problem info cache
+  @param problem_dir Either a name of the problem directory or its full path
+  @param name A name of the annotation, must not contain '=' nor new lines
+  @param value A value of the annotation
+*/
+#define problem_info_cache_annotate abrt_problem_info_cache_annotate
+void problem_info_cache_annotate(problem_info_cache_t *cache, const char *problem_dir,
+                const char *name, const char *value);
+
+/**
+  @brief Finds problems having the element of the value which last occurred
+  in the time range
+
+  Brings the cache up to date with the dump location if a problem was
+  created or deleted or if the cache file was updated since the last call,
+  and looks the problems up in an index of the element. Changes of existing
+  problems are seen once abrtd updates the cache file. Problems which could not be cached are read
+  directly. A missing element is considered empty.
+
+  @param cache An instance of problem info cache
+  @param element A name of a cached element
+  @param value A value of the element
+  @param from The lowest last occurrence
+  @param to The highest last occurrence
+  @param problems Set to a list of full paths of the problems sorted by their
+  last occurrence, must be freed by list_free_with_free()
+  @return 0 on success; -EINVAL if the element is not cached; otherwise the
+  negative errno returned by problem_info_cache_sync()
+*/
+#define problem_info_cache_find abrt_problem_info_cache_find
+int problem_info_cache_find(problem_info_cache_t *cache, const char *element, const char *value,
+                unsigned long from, unsigned long to, GList **problems);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,6 +29,7 @@ char *        g_settings_autoreporting_event = NULL;
 bool          g_settings_shortenedreporting = 0;
 bool          g_settings_explorechroots = 0;
 unsigned int  g_settings_debug_level = 0;
+unsigned int  g_settings_nMaxPostCreateProcesses = 0;
 
 void free_abrt_conf_data()
 {
@@ -156,6 +157,21 @@ static void ParseCommon(map_string_t *settings, const char *conf_filename)
         remove_map_string_item(settings, "DebugLevel");
     }
 
+    value = get_map_string_item_or_NULL(settings, "MaxPostCreateProcesses");
+    if (value)
+    {
+        char *end;
+        errno = 0;
+        unsigned long ul = strtoul(value, &end, 10);
+        if (errno || end == value || *end != '\0' || ul > INT_MAX)
+            error_msg("Error parsing %s setting: '%s'", "MaxPostCreateProcesses", value);
+        else
+            g_settings_nMaxPostCreateProcesses = ul;
+        remove_map_string_item(settings, "MaxPostCreateProcesses");
+    }
+    else
+        g_settings_nMaxPostCreateProcesses = 0;
+
     GHashTableIter iter;
     const char *name;
     /*char *value; - already declared */
@@ -207,6 +223,53 @@ int load_abrt_conf_file(const char *file, map_string_t *settings)
     return load_conf_file_from_dirs(file, conf_directories, settings, /*skip key w/o values:*/ false);
 }
 
+/* Identity of a configuration file used to detect its modifications */
+struct conf_file_stamp
+{
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+};
+
+static void get_abrt_conf_stamps(struct conf_file_stamp *stamps, size_t count)
+{
+    const char *const abrt_conf = get_abrt_conf_file_name();
+    const char *const *conf_directories = get_conf_directories();
+
+    memset(stamps, 0, count * sizeof(*stamps));
+    for (size_t i = 0; i < count && conf_directories[i] != NULL; ++i)
+    {
+        char *path = abrt_conf[0] == '/' ? xstrdup(abrt_conf) : concat_path_file(conf_directories[i], abrt_conf);
+        struct stat st;
+        if (stat(path, &st) == 0)
+        {
+            stamps[i].dev = st.st_dev;
+            stamps[i].ino = st.st_ino;
+            stamps[i].size = st.st_size;
+            stamps[i].mtime = st.st_mtim;
+        }
+        free(path);
+    }
+}
+
+int load_abrt_conf_if_changed(void)
+{
+    static struct conf_file_stamp loaded[2];
+    static bool is_loaded;
+
+    struct conf_file_stamp current[ARRAY_SIZE(loaded)];
+    get_abrt_conf_stamps(current, ARRAY_SIZE(current));
+
+    if (is_loaded && g_settings_dump_location != NULL && memcmp(current, loaded, sizeof(loaded)) == 0)
+        return 0;
+
+    log_debug("Loading the abrt configuration");
+    memcpy(loaded, current, sizeof(loaded));
+    is_loaded = true;
+    return load_abrt_conf();
+}
+
 int load_abrt_plugin_conf_file(const char *file, map_string_t *settings)
 {
     static const char *const base_directories[] = { DEFAULT_PLUGINS_CONF_DIR, PLUGINS_CONF_DIR, NULL };
@@ -15,6 +15,7 @@
     with this program; if not, write to the Free Software Foundation, Inc.,
     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 */
+#include <sys/file.h>
 #include "libabrt.h"
 
 /* I want to use -Werror, but gcc-4.4 throws a curveball:
@@ -57,3 +58,151 @@ int check_recent_crash_file(const char *filename, const char *executable)
     close(fd);
     return 0;
 }
+
+/* The file holds one line per executable:
+ *   TOKENS LAST_UPDATE SUPPRESSED EXECUTABLE
+ */
+#define CRASH_RATE_MAX_EXECUTABLES 64
+
+char *crash_rate_read_entry(FILE *fp, const char *filename, struct abrt_crash_rate_bucket *bucket)
+{
+    char *line;
+    while ((line = xmalloc_fgetline(fp)) != NULL)
+    {
+        int ofs = 0;
+        if (sscanf(line, "%lf %lld %u %n", &bucket->tokens, &bucket->last_update, &bucket->suppressed, &ofs) == 3
+         && line[ofs] != '\0')
+        {
+            char *executable = xstrdup(line + ofs);
+            free(line);
+            return executable;
+        }
+
+        log_notice("Ignoring malformed line in '%s'", filename);
+        free(line);
+    }
+
+    return NULL;
+}
+
+void crash_rate_write_entry(FILE *fp, const char *executable, const struct abrt_crash_rate_bucket *bucket)
+{
+    fprintf(fp, "%f %lld %u %s\n", bucket->tokens, bucket->last_update,
+            bucket->suppressed, executable);
+}
+
+void crash_rate_bucket_init(struct abrt_crash_rate_bucket *bucket, unsigned max_crashes, long long now)
+{
+    bucket->tokens = max_crashes;
+    bucket->last_update = now;
+    bucket->suppressed = 0;
+}
+
+/* Token bucket: refill max_crashes tokens per window_sec seconds */
+int crash_rate_bucket_take(struct abrt_crash_rate_bucket *bucket, unsigned max_crashes,
+                unsigned window_sec, long long now, unsigned *suppressed)
+{
+    if (now > bucket->last_update)
+        bucket->tokens += (double)(now - bucket->last_update) * max_crashes / window_sec;
+    if (bucket->tokens > max_crashes)
+        bucket->tokens = max_crashes;
+    bucket->last_update = now;
+
+    if (bucket->tokens < 1.0)
+    {
+        *suppressed = ++bucket->suppressed;
+        return 1;
+    }
+
+    bucket->tokens -= 1.0;
+    *suppressed = bucket->suppressed;
+    bucket->suppressed = 0;
+    return 0;
+}
+
+struct crash_rate_entry
+{
+    struct abrt_crash_rate_bucket bucket;
+    char *executable;
+};
+
+int check_crash_rate_file(const char *filename, const char *executable,
+                unsigned max_crashes, unsigned window_sec, unsigned *suppressed)
+{
+    *suppressed = 0;
+    if (max_crashes == 0 || window_sec == 0 || strchr(executable, '\n') != NULL)
+        return 0;
+
+    int fd = open(filename, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        perror_msg("Can't open '%s'", filename);
+        return 0;
+    }
+
+    /* Concurrent hooks must not lose their updates */
+    if (flock(fd, LOCK_EX) != 0)
+    {
+        perror_msg("Can't lock '%s'", filename);
+        close(fd);
+        return 0;
+    }
+
+    FILE *fp = fdopen(fd, "r+");
+    if (fp == NULL)
+    {
+        perror_msg("Can't open '%s'", filename);
+        close(fd);
+        return 0;
+    }
+
+    struct crash_rate_entry entries[CRASH_RATE_MAX_EXECUTABLES];
+    unsigned cnt = 0;
+    int found = -1;
+    while (cnt < CRASH_RATE_MAX_EXECUTABLES)
+    {
+        struct crash_rate_entry *e = &entries[cnt];
+        e->executable = crash_rate_read_entry(fp, filename, &e->bucket);
+        if (e->executable == NULL)
+            break;
+
+        if (strcmp(e->executable, executable) == 0)
+            found = cnt;
+        ++cnt;
+    }
+
+    const long long now = time(NULL);
+    if (found < 0)
+    {
+        if (cnt == CRASH_RATE_MAX_EXECUTABLES)
+        {   /* Forget the executable which has not crashed for the longest time */
+            unsigned oldest = 0;
+            for (unsigned i = 1; i < cnt; ++i)
+                if (entries[i].bucket.last_update < entries[oldest].bucket.last_update)
+                    oldest = i;
+
+            free(entries[oldest].executable);
+            entries[oldest] = entries[--cnt];
+        }
+
+        found = cnt++;
+        crash_rate_bucket_init(&entries[found].bucket, max_crashes, now);
+        entries[found].executable = xstrdup(executable);
+    }
+
+    const int throttled = crash_rate_bucket_take(&entries[found].bucket, max_crashes,
+                                                 window_sec, now, suppressed);
+
+    rewind(fp);
+    for (unsigned i = 0; i < cnt; ++i)
+    {
+        crash_rate_write_entry(fp, entries[i].executable, &entries[i].bucket);
+        free(entries[i].executable);
+    }
+    fflush(fp);
+    IGNORE_RESULT(ftruncate(fd, ftell(fp)));
+
+    /* Releases the lock too */
+    fclose(fp);
+    return throttled;
+}
@@ -63,25 +63,28 @@ void trim_problem_dirs(const char *dirname, double cap_size, const char *exclude
     }
     log_debug("excluded_basename:'%s'", excluded_basename);
 
+    GList *worst_dirs = NULL;
+    /* We exclude our own dir from candidates for deletion (3rd param): */
+    double cur_size = get_dirsize_find_worst_dirs(dirname, &worst_dirs, excluded_basename);
+
     int count = 20;
-    while (--count >= 0)
+    for (GList *li = worst_dirs; li != NULL && --count >= 0; li = g_list_next(li))
     {
-        /* We exclude our own dir from candidates for deletion (3rd param): */
-        char *worst_basename = NULL;
-        double cur_size = get_dirsize_find_largest_dir(dirname, &worst_basename, excluded_basename);
-        if (cur_size <= cap_size || !worst_basename)
-        {
-            log_info("cur_size:%.0f cap_size:%.0f, no (more) trimming", cur_size, cap_size);
-            free(worst_basename);
+        if (cur_size <= cap_size)
             break;
-        }
+
+        const struct dir_size *worst = (const struct dir_size *)li->data;
         log("%s is %.0f bytes (more than %.0fMiB), deleting '%s'",
-                dirname, cur_size, cap_size / (1024*1024), worst_basename);
-        char *d = concat_path_file(dirname, worst_basename);
-        free(worst_basename);
-        delete_dump_dir(d);
+                dirname, cur_size, cap_size / (1024*1024), worst->name);
+        char *d = concat_path_file(dirname, worst->name);
+        /* A locked directory can't be deleted, try the next one */
+        if (delete_dump_dir(d) == 0)
+            cur_size -= worst->size;
         free(d);
     }
+    log_info("cur_size:%.0f cap_size:%.0f, no (more) trimming", cur_size, cap_size);
+
+    g_list_free_full(worst_dirs, free);
 }
 
 /**
@@ -172,6 +175,141 @@ static char* exec_vp(char **args, int redirect_stderr, int exec_timeout_sec, int
     return strbuf_free_nobuf(buf_out);
 }
 
+/* Core dumps compressed by abrt-hook-ccpp (see CoreCompression in CCpp.conf)
+ * or adopted from systemd-coredump (see SystemdCoredumpAdoption) */
+static const struct compressed_coredump
+{
+    const char *name;
+    const char *decompressor;
+} s_compressed_coredumps[] = {
+    { FILENAME_COREDUMP_LZ4, "lz4"  },
+    { FILENAME_COREDUMP_ZST, "zstd" },
+    { FILENAME_COREDUMP_XZ,  "xz"   },
+};
+
+static bool has_compressed_coredump(const char *dump_dir_name)
+{
+    bool found = false;
+    for (unsigned i = 0; !found && i < ARRAY_SIZE(s_compressed_coredumps); ++i)
+    {
+        char *packed_path = concat_path_file(dump_dir_name, s_compressed_coredumps[i].name);
+        struct stat st;
+        found = lstat(packed_path, &st) == 0 && S_ISREG(st.st_mode);
+        free(packed_path);
+    }
+
+    return found;
+}
+
+int unpack_compressed_coredump(const char *dump_dir_name)
+{
+    char *raw_path = concat_path_file(dump_dir_name, FILENAME_COREDUMP);
+    int ret = 0;
+    if (access(raw_path, F_OK) == 0)
+        goto finito;
+
+    ret = -1;
+    for (unsigned i = 0; i < ARRAY_SIZE(s_compressed_coredumps); ++i)
+    {
+        char *packed_path = concat_path_file(dump_dir_name, s_compressed_coredumps[i].name);
+        const int src_fd = open(packed_path, O_RDONLY | O_NOFOLLOW);
+        if (src_fd < 0)
+        {
+            free(packed_path);
+            continue;
+        }
+
+        struct stat st;
+        if (fstat(src_fd, &st) != 0 || !S_ISREG(st.st_mode))
+        {
+            error_msg("'%s' is not a regular file", packed_path);
+            goto next;
+        }
+
+        char *tmp_path = xasprintf("%s.unpacking", raw_path);
+        const int dst_fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, st.st_mode & 0777);
+        if (dst_fd < 0)
+        {
+            perror_msg("Can't create '%s'", tmp_path);
+            free(tmp_path);
+            goto next;
+        }
+        /* Keep the ownership, the problem directory may belong to another user */
+        if (fchown(dst_fd, st.st_uid, st.st_gid) != 0)
+            perror_msg("Can't change ownership of '%s'", tmp_path);
+
+        log_notice("Decompressing '%s'", packed_path);
+
+        const char *decompressor = s_compressed_coredumps[i].decompressor;
+        pid_t child = fork();
+        if (child < 0)
+            perror_msg("fork");
+        else if (child == 0)
+        {
+            xmove_fd(src_fd, STDIN_FILENO);
+            xmove_fd(dst_fd, STDOUT_FILENO);
+            execlp(decompressor, decompressor, "-d", "-c", "-q", NULL);
+            perror_msg_and_die("Can't execute '%s'", decompressor);
+        }
+
+        int status = -1;
+        if (child > 0)
+            safe_waitpid(child, &status, 0);
+
+        struct stat dst_st;
+        if (fsync(dst_fd) != 0 || fstat(dst_fd, &dst_st) != 0)
+            status = -1;
+        close(dst_fd);
+
+        /* The compressed core can be truncated by MaxCoreFileSize, in which
+         * case the decompressor fails but the data are as useful as data of
+         * a truncated raw core.
+         */
+        if (status != -1 && WIFEXITED(status) && dst_st.st_size > 0)
+        {
+            if (WEXITSTATUS(status) != 0)
+                log_warning("'%s' is damaged or truncated", packed_path);
+
+            /* The compressed core dump is kept, the raw one is only
+             * a temporary copy for the caller */
+            if (rename(tmp_path, raw_path) == 0)
+                ret = 1;
+            else
+                perror_msg("Can't rename '%s' to '%s'", tmp_path, raw_path);
+        }
+        else
+            error_msg("Failed to decompress '%s'", packed_path);
+
+        if (ret < 0)
+            unlink(tmp_path);
+        free(tmp_path);
+ next:
+        close(src_fd);
+        free(packed_path);
+        break;
+    }
+
+ finito:
+    free(raw_path);
+    return ret;
+}
+
+void remove_unpacked_coredump(const char *dump_dir_name, int unpacked)
+{
+    if (unpacked <= 0)
+        return;
+
+    /* Never remove the only copy of the core dump */
+    if (!has_compressed_coredump(dump_dir_name))
+        return;
+
+    char *raw_path = concat_path_file(dump_dir_name, FILENAME_COREDUMP);
+    log_notice("Removing temporary '%s'", raw_path);
+    if (unlink(raw_path) != 0 && errno != ENOENT)
+        perror_msg("Can't remove '%s'", raw_path);
+    free(raw_path);
+}
+
 char *run_unstrip_n(const char *dump_dir_name, unsigned timeout_sec)
 {
     int flags = EXECFLG_INPUT_NUL | EXECFLG_OUTPUT | EXECFLG_SETSID | EXECFLG_QUIET;
@@ -243,9 +381,15 @@ char *get_backtrace(const char *dump_dir_name, unsigned timeout_sec, const char
 {
     INITIALIZE_LIBABRT();
 
+    /* GDB can't read compressed core dumps */
+    const int unpacked = unpack_compressed_coredump(dump_dir_name);
+
     struct dump_dir *dd = dd_opendir(dump_dir_name, /*flags:*/ 0);
     if (!dd)
+    {
+        remove_unpacked_coredump(dump_dir_name, unpacked);
         return NULL;
+    }
 
     char *executable = NULL;
     if (dd_exist(dd, FILENAME_BINARY))
@@ -409,6 +553,8 @@ char *get_backtrace(const char *dump_dir_name, unsigned timeout_sec, const char
     free(args[debug_dir_cmd_index]);
     free(args[file_cmd_index]);
     free(args[core_cmd_index]);
+
+    remove_unpacked_coredump(dump_dir_name, unpacked);
     return bt;
 }
 
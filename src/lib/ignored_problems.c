@@ -23,15 +23,27 @@
 #define IGN_DD_OPEN_FLAGS (DD_OPEN_READONLY | DD_FAIL_QUIETLY_ENOENT | DD_FAIL_QUIETLY_EACCES)
 #define IGN_DD_LOAD_TEXT_FLAGS (DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE | DD_FAIL_QUIETLY_ENOENT | DD_FAIL_QUIETLY_EACCES)
 
+/* The file is indexed in memory in order to avoid parsing the whole file for
+ * every single query. The index is valid as long as the file has the same
+ * identity, size and modification time as the indexed version.
+ */
 struct ignored_problems
 {
     char *ign_set_file_path;
+    GHashTable *ign_ids;
+    GHashTable *ign_uuids;
+    GHashTable *ign_duphashes;
+    struct stat ign_indexed_stat;
+    bool ign_indexed;
 };
 
 ignored_problems_t *ignored_problems_new(char *set_file_path)
 {
-    ignored_problems_t *set = xmalloc(sizeof(*set));
+    ignored_problems_t *set = xzalloc(sizeof(*set));
     set->ign_set_file_path = set_file_path;
+    set->ign_ids = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    set->ign_uuids = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    set->ign_duphashes = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
     return set;
 }
 
@@ -39,10 +51,102 @@ void ignored_problems_free(ignored_problems_t *set)
 {
     if (!set)
         return;
+    g_hash_table_destroy(set->ign_duphashes);
+    g_hash_table_destroy(set->ign_uuids);
+    g_hash_table_destroy(set->ign_ids);
     free(set->ign_set_file_path);
     free(set);
 }
 
+static void ignored_problems_index_column(GHashTable *index, const char *column, const char *column_end)
+{
+    if (column == column_end)
+        return;
+
+    char *value = xstrndup(column, column_end - column);
+    g_hash_table_add(index, value);
+}
+
+static void ignored_problems_index_line(ignored_problems_t *set, const char *line, unsigned line_num)
+{
+    const char *column = line;
+    const char *column_end = strchrnul(column, IGN_COLUMN_DELIMITER);
+    ignored_problems_index_column(set->ign_ids, column, column_end);
+
+    if (column_end[0] == '\0')
+    {
+        log_notice("No 2nd column (UUID) at line %d in ignored problems file '%s'",
+                line_num, set->ign_set_file_path);
+        return;
+    }
+    column = column_end + 1;
+    column_end = strchrnul(column, IGN_COLUMN_DELIMITER);
+    ignored_problems_index_column(set->ign_uuids, column, column_end);
+
+    if (column_end[0] == '\0')
+    {
+        log_notice("No 3rd column (DUPHASH) at line %d in ignored problems file '%s'",
+                line_num, set->ign_set_file_path);
+        return;
+    }
+    column = column_end + 1;
+    column_end = strchrnul(column, IGN_COLUMN_DELIMITER);
+    ignored_problems_index_column(set->ign_duphashes, column, column_end);
+}
+
+static bool ignored_problems_stat_eq(const struct stat *lhs, const struct stat *rhs)
+{
+    return lhs->st_dev == rhs->st_dev
+        && lhs->st_ino == rhs->st_ino
+        && lhs->st_size == rhs->st_size
+        && lhs->st_mtim.tv_sec == rhs->st_mtim.tv_sec
+        && lhs->st_mtim.tv_nsec == rhs->st_mtim.tv_nsec;
+}
+
+/* Re-reads the file only if it was changed since the last call. */
+static void ignored_problems_refresh_index(ignored_problems_t *set)
+{
+    /* stat() must precede reading, so a concurrent change of the file
+     * invalidates the index at the latest in the next call. */
+    struct stat st;
+    if (stat(set->ign_set_file_path, &st) != 0)
+    {
+        if (errno != ENOENT)
+            pwarn_msg("Can't stat ignored problems '%s'", set->ign_set_file_path);
+        memset(&st, 0, sizeof(st));
+    }
+
+    if (set->ign_indexed && ignored_problems_stat_eq(&st, &set->ign_indexed_stat))
+        return;
+
+    g_hash_table_remove_all(set->ign_ids);
+    g_hash_table_remove_all(set->ign_uuids);
+    g_hash_table_remove_all(set->ign_duphashes);
+    set->ign_indexed_stat = st;
+    set->ign_indexed = true;
+
+    FILE *fp = fopen(set->ign_set_file_path, "r");
+    if (!fp)
+    {
+        if (errno != ENOENT)
+            pwarn_msg("Can't open ignored problems '%s' in mode '%s'", set->ign_set_file_path, "r");
+        return;
+    }
+
+    log_debug("Indexing ignored problems '%s'", set->ign_set_file_path);
+
+    unsigned line_num = 0;
+    char *line;
+    while ((line = xmalloc_fgetline(fp)) != NULL)
+    {
+        ++line_num;
+        ignored_problems_index_line(set, line, line_num);
+        free(line);
+    }
+
+    fclose(fp);
+}
+
 static bool ignored_problems_eq(ignored_problems_t *set,
         const char *problem_id, const char *uuid, const char *duphash,
         const char *line, unsigned line_num)
@@ -90,36 +194,29 @@ static bool ignored_problems_eq(ignored_problems_t *set,
 }
 
 static bool ignored_problems_file_contains(ignored_problems_t *set,
-        const char *problem_id, const char *uuid, const char *duphash,
-        FILE **out_fp, const char *mode)
+        const char *problem_id, const char *uuid, const char *duphash)
 {
-    bool found = false;
-    FILE *fp = fopen(set->ign_set_file_path, mode);
-    if (!fp)
+    ignored_problems_refresh_index(set);
+
+    if (problem_id != NULL && g_hash_table_contains(set->ign_ids, problem_id))
     {
-        if (errno != ENOENT)
-            pwarn_msg("Can't open ignored problems '%s' in mode '%s'", set->ign_set_file_path, mode);
-        goto ret_contains_end;
+        log_notice("Ignored id matches '%s'", problem_id);
+        return true;
     }
 
-    unsigned line_num = 0;
-    while (!found)
+    if (uuid != NULL && g_hash_table_contains(set->ign_uuids, uuid))
     {
-        char *line = xmalloc_fgetline(fp);
-        if (!line)
-            break;
-        ++line_num;
-        found = ignored_problems_eq(set, problem_id, uuid, duphash, line, line_num);
-        free(line);
+        log_notice("Ignored uuid '%s' matches uuid of problem '%s'", uuid, problem_id);
+        return true;
     }
 
- ret_contains_end:
-    if (out_fp)
-        *out_fp = fp;
-    else if (fp)
-        fclose(fp);
+    if (duphash != NULL && g_hash_table_contains(set->ign_duphashes, duphash))
+    {
+        log_notice("Ignored duphash '%s' matches duphash of problem '%s'", duphash, problem_id);
+        return true;
+    }
 
-    return found;
+    return false;
 }
 
 static void ignored_problems_add_row(ignored_problems_t *set, const char *problem_id,
@@ -127,9 +224,14 @@ static void ignored_problems_add_row(ignored_problems_t *set, const char *proble
 {
     log_notice("Going to add problem '%s' to ignored problems", problem_id);
 
-    FILE *fp;
-    if (!ignored_problems_file_contains(set, problem_id, uuid, duphash, &fp, "a+"))
+    FILE *fp = NULL;
+    if (!ignored_problems_file_contains(set, problem_id, uuid, duphash))
     {
+        /* Append only, the index is refreshed by the next query */
+        fp = fopen(set->ign_set_file_path, "a");
+        if (!fp)
+            pwarn_msg("Can't open ignored problems '%s' in mode '%s'", set->ign_set_file_path, "a");
+
         if (fp)
         {
             /* We can add write error checks here.
@@ -197,34 +299,26 @@ void ignored_problems_remove_row(ignored_problems_t *set, const char *problem_id
 
     VERB1 log("Going to remove problem '%s' from ignored problems", problem_id);
 
-    FILE *orig_fp;
-    if (!ignored_problems_file_contains(set, problem_id, uuid, duphash, &orig_fp, "r"))
+    if (!ignored_problems_file_contains(set, problem_id, uuid, duphash))
     {
-        if (orig_fp)
-        {
-            log_notice("Won't remove problem '%s' from ignored problems:"
-                      " it is already removed", problem_id);
-            /* Close orig_fp here becuase it looks like much simpler than
-             * exetendig the set of goto labels at the end of this function */
-            fclose(orig_fp);
-        }
-        else
-        {
-            /* This is not a fatal problem. We are permissive because we don't want
-             * to scare users by strange error messages.
-             */
-            log_notice("Can't remove problem '%s' from ignored problems:"
-                      " can't open the list", problem_id);
-        }
+        log_notice("Won't remove problem '%s' from ignored problems:"
+                  " it is already removed", problem_id);
         return;
     }
 
-    /* orig_fp must be valid here because if ignored_problems_file_contains()
-     * returned TRUE the function ensures that orig_fp is set to a valid FILE*.
-     *
-     * But the function moved the file position indicator.
+    /* Removing is rare, so the file is rewritten without the matching rows
+     * in order to keep the format readable by other tools.
      */
-    rewind(orig_fp);
+    FILE *orig_fp = fopen(set->ign_set_file_path, "r");
+    if (!orig_fp)
+    {
+        /* This is not a fatal problem. We are permissive because we don't want
+         * to scare users by strange error messages.
+         */
+        log_notice("Can't remove problem '%s' from ignored problems:"
+                  " can't open the list", problem_id);
+        return;
+    }
 
     char *new_tempfile_name = xasprintf("%s.XXXXXX", set->ign_set_file_path);
     int new_tempfile_fd = mkstemp(new_tempfile_name);
@@ -318,8 +412,7 @@ bool ignored_problems_contains_problem_data(ignored_problems_t *set, problem_dat
     return ignored_problems_file_contains(set,
             problem_data_get_content_or_NULL(pd, CD_DUMPDIR),
             problem_data_get_content_or_NULL(pd, FILENAME_UUID),
-            problem_data_get_content_or_NULL(pd, FILENAME_DUPHASH),
-            /* (FILE **) */NULL, "r"
+            problem_data_get_content_or_NULL(pd, FILENAME_DUPHASH)
             );
 }
 
@@ -345,8 +438,7 @@ bool ignored_problems_contains(ignored_problems_t *set, const char *problem_id)
     log_notice("Going to check if problem '%s' is in ignored problems '%s'",
             problem_id, set->ign_set_file_path);
 
-    bool found = ignored_problems_file_contains(set, problem_id, uuid, duphash,
-                    /* (FILE **) */NULL, "r");
+    bool found = ignored_problems_file_contains(set, problem_id, uuid, duphash);
 
     free(duphash);
     free(uuid);
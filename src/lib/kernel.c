@@ -29,6 +29,10 @@
  */
 #define SANE_MIN_OOPS_LEN 30
 
+/* Longer oopses are dropped, an oops is always finished within this number
+ * of lines after its first line (see koops_extract_oopses_from_lines()) */
+#define SANE_MAX_OOPS_LINES 100
+
 static void record_oops(GList **oops_list, const struct abrt_koops_line_info* lines_info, int oopsstart, int oopsend)
 {
     int q;
@@ -150,6 +154,26 @@ static const char *const s_koops_suspicious_strings[] = {
     NULL
 };
 
+/* Searching for all suspicious strings in every line is the most expensive
+ * part of scanning long logs. The strings are constant, so the matcher is
+ * compiled on the first use and kept for the lifetime of the process.
+ */
+static const strings_matcher_t *suspicious_strings_matcher(void)
+{
+    static strings_matcher_t *matcher = NULL;
+    static gsize initialized = 0;
+
+    if (g_once_init_enter(&initialized))
+    {
+        GList *suspicious_strings = koops_suspicious_strings_list();
+        matcher = strings_matcher_new(suspicious_strings);
+        g_list_free(suspicious_strings);
+        g_once_init_leave(&initialized, 1);
+    }
+
+    return matcher;
+}
+
 void koops_print_suspicious_strings(void)
 {
     koops_print_suspicious_strings_filtered(NULL);
@@ -237,7 +261,19 @@ int koops_line_skip_level(const char **c)
     return linelevel;
 }
 
-void koops_extract_oopses(GList **oops_list, char *buffer, size_t buflen)
+/* What follows the lines passed to extract_oopses_from_lines() */
+enum following_lines
+{
+    NO_MORE_LINES,      /* nothing, the lines are complete */
+    MORE_LINES,         /* the lines continue in the next chunk */
+    PENDING_LINES,      /* the lines end at the end of the log for now */
+};
+
+static int extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_line_info *lines_info, int lines_info_size, enum following_lines following);
+
+/* Returns the number of bytes of the buffer which were completely processed,
+ * see extract_oopses_from_lines() */
+static size_t extract_oopses(GList **oops_list, char *buffer, size_t buflen, enum following_lines following)
 {
     char *c;
     int linecount = 0;
@@ -317,21 +353,79 @@ next_line:
         c = c9 + 1;
     }
 
-    koops_extract_oopses_from_lines(oops_list, lines_info, lines_info_size);
+    size_t processed = buflen;
+    const int resume = extract_oopses_from_lines(oops_list, lines_info, lines_info_size, following);
+    if (resume < lines_info_size)
+    {
+        /* The pointer points behind the skipped syslog prefix, the line
+         * starts after the previous line's terminating '\0' */
+        const char *line = lines_info[resume].ptr;
+        while (line > buffer && line[-1] != '\0')
+            --line;
+
+        processed = line - buffer;
+    }
+
     free(lines_info);
+    return processed;
+}
+
+void koops_extract_oopses(GList **oops_list, char *buffer, size_t buflen)
+{
+    extract_oopses(oops_list, buffer, buflen, NO_MORE_LINES);
+}
+
+size_t koops_extract_oopses_from_chunk(GList **oops_list, char *buffer, size_t buflen, bool last_chunk)
+{
+    /* Only complete lines are processed */
+    const char *last_newline = memrchr(buffer, '\n', buflen);
+    if (last_newline == NULL)
+        return 0;
+
+    const size_t lines_len = last_newline - buffer + 1;
+    const size_t processed = extract_oopses(oops_list, buffer, lines_len,
+                                            last_chunk ? PENDING_LINES : MORE_LINES);
+
+    /* The caller passes the rest again, restore its new lines */
+    for (char *c = buffer + processed; c < buffer + lines_len; ++c)
+    {
+        if (*c == '\0')
+            *c = '\n';
+    }
+
+    return processed;
 }
 
 void koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_line_info *lines_info, int lines_info_size)
+{
+    extract_oopses_from_lines(oops_list, lines_info, lines_info_size, NO_MORE_LINES);
+}
+
+/* If following is not NO_MORE_LINES, the lines are followed by lines which
+ * are not available yet. An oops which might continue in the following lines
+ * is not recorded, the index of its first line is returned instead, so the
+ * caller can pass the lines again together with the following ones. Otherwise
+ * returns lines_info_size.
+ *
+ * MORE_LINES defers every oops starting in the last SANE_MAX_OOPS_LINES lines,
+ * so the result does not depend on where the log is split into chunks.
+ * PENDING_LINES defers only an oops which has not ended in the available
+ * lines, because the following lines might not come for a long time.
+ */
+static int extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_line_info *lines_info, int lines_info_size, enum following_lines following)
 {
     /* Analyze lines */
 
     int i;
+    int resume = lines_info_size;
     char prevlevel = 0;
     int oopsstart = -1;
     int inbacktrace = 0;
     regex_t arm_regex;
     int arm_regex_rc = 0;
 
+    const strings_matcher_t *suspicious_matcher = suspicious_strings_matcher();
+
     /* ARM backtrace regex, match a string similar to r7:df912310 */
     arm_regex_rc = regcomp(&arm_regex, "r[[:digit:]]{1,}:[a-f[:digit:]]{8}", REG_EXTENDED | REG_NOSUB);
 
@@ -351,13 +445,16 @@ void koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_
         if (oopsstart < 0)
         {
             /* Find start-of-oops markers */
-            for (const char *const *str = s_koops_suspicious_strings; *str; ++str)
+            if (strings_matcher_find(suspicious_matcher, curline))
             {
-                if (strstr(curline, *str))
+                /* The end of the oops might be in the following lines */
+                if (following == MORE_LINES && lines_info_size - i <= SANE_MAX_OOPS_LINES)
                 {
-                    oopsstart = i;
+                    resume = i;
                     break;
                 }
+
+                oopsstart = i;
             }
 
             if (oopsstart >= 0)
@@ -452,14 +549,8 @@ void koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_
             else
             {
                 /* if a new oops starts, this one has ended */
-                for (const char *const *str = s_koops_suspicious_strings; *str; ++str)
-                {
-                    if (strstr(curline, *str))
-                    {
-                        oopsend = i-1;
-                        break;
-                    }
-                }
+                if (strings_matcher_find(suspicious_matcher, curline))
+                    oopsend = i-1;
             }
 
             if (oopsend <= i)
@@ -503,7 +594,9 @@ void koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_
     regfree(&arm_regex);
 
     /* process last oops if we have one */
-    if (oopsstart >= 0)
+    if (oopsstart >= 0 && following != NO_MORE_LINES)
+        resume = oopsstart;
+    else if (oopsstart >= 0)
     {
         if (inbacktrace)
         {
@@ -517,6 +610,8 @@ void koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_
             record_oops(oops_list, lines_info, oopsstart, oopsstart);
         }
     }
+
+    return resume;
 }
 int koops_hash_str_ext(char result[SHA1_RESULT_LEN*2 + 1], const char *oops_buf, int frame_count, int duphash_flags)
 {
@@ -21,6 +21,63 @@
 #include <sys/time.h>
 #include "problem_api.h"
 
+/*
+ * Opens the problem @name in @path and calls callback if the problem is
+ * accessible by caller_uid. Returns the callback's value.
+ */
+static int process_problem_in_dir(const char *path,
+                        int dir_fd,
+                        const char *name,
+                        unsigned char d_type,
+                        uid_t caller_uid,
+                        for_each_problem_in_dir_callback callback,
+                        void *arg)
+{
+    /* Skip files like .lock or last-ccpp without trying to open them */
+    if (d_type == DT_UNKNOWN || d_type == DT_LNK)
+    {
+        struct stat st;
+        if (fstatat(dir_fd, name, &st, 0) != 0 || !S_ISDIR(st.st_mode))
+            return 0;
+    }
+    else if (d_type != DT_DIR)
+        return 0;
+
+    char *full_name = concat_path_file(path, name);
+
+    struct dump_dir *dd = dd_opendir(full_name,   DD_OPEN_FD_ONLY
+                                                | DD_FAIL_QUIETLY_ENOENT
+                                                | DD_FAIL_QUIETLY_EACCES);
+    if (dd == NULL)
+    {
+        VERB2 perror_msg("can't open problem directory '%s'", full_name);
+        free(full_name);
+        return 0;
+    }
+
+    int brk = 0;
+    if (caller_uid == -1 || dd_accessible_by_uid(dd, caller_uid))
+    {
+        /* Silently ignore *any* errors, not only EACCES.
+         * We saw "lock file is locked by process PID" error
+         * when we raced with wizard.
+         */
+        int sv_logmode = logmode;
+        /* Silently ignore errors only in the silent log level. */
+        logmode = g_verbose == 0 ? 0: sv_logmode;
+        dd = dd_fdopendir(dd, DD_OPEN_READONLY | DD_DONT_WAIT_FOR_LOCK);
+        logmode = sv_logmode;
+        if (dd)
+            brk = callback ? callback(dd, arg) : 0;
+    }
+
+    if (dd)
+        dd_close(dd);
+
+    free(full_name);
+    return brk;
+}
+
 /*
  * Goes through all problems and for problems accessible by caller_uid
  * calls callback. If callback returns non-0, returns that value.
@@ -45,37 +102,8 @@ int for_each_problem_in_dir(const char *path,
         if (dot_or_dotdot(dent->d_name))
             continue; /* skip "." and ".." */
 
-        char *full_name = concat_path_file(path, dent->d_name);
-
-        struct dump_dir *dd = dd_opendir(full_name,   DD_OPEN_FD_ONLY
-                                                    | DD_FAIL_QUIETLY_ENOENT
-                                                    | DD_FAIL_QUIETLY_EACCES);
-        if (dd == NULL)
-        {
-            VERB2 perror_msg("can't open problem directory '%s'", full_name);
-            free(full_name);
-            continue;
-        }
-
-        if (caller_uid == -1 || dd_accessible_by_uid(dd, caller_uid))
-        {
-            /* Silently ignore *any* errors, not only EACCES.
-             * We saw "lock file is locked by process PID" error
-             * when we raced with wizard.
-             */
-            int sv_logmode = logmode;
-            /* Silently ignore errors only in the silent log level. */
-            logmode = g_verbose == 0 ? 0: sv_logmode;
-            dd = dd_fdopendir(dd, DD_OPEN_READONLY | DD_DONT_WAIT_FOR_LOCK);
-            logmode = sv_logmode;
-            if (dd)
-                brk = callback ? callback(dd, arg) : 0;
-        }
-
-        if (dd)
-            dd_close(dd);
-
-        free(full_name);
+        brk = process_problem_in_dir(path, dirfd(dp), dent->d_name, dent->d_type,
+                                     caller_uid, callback, arg);
         if (brk)
             break;
     }
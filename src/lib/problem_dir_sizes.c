@@ -0,0 +1,284 @@
+/*
+    Copyright (C) 2016  ABRT Team
+    Copyright (C) 2016  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "internal_libabrt.h"
+
+/* Sizes of problem directories are cached in a file in the dump location in
+ * order to avoid recursive stat() of all files of all problem directories in
+ * every trimming.
+ *
+ * A line of the file:
+ *   MTIME_SEC MTIME_NSEC SIZE DIRECTORY_NAME
+ *
+ * A cached size is valid only if the modification time of the directory is
+ * equal to the cached one. Creating, renaming or deleting a file in
+ * a directory changes the modification time and libreport replaces files
+ * instead of modifying them in place.
+ *
+ * Modification times have a coarse granularity, so a change made shortly
+ * after measuring could end up with the same time. Hence, sizes of
+ * directories modified in the last two seconds are not cached.
+ *
+ * Files growing in place (e.g. a core dump being streamed) do not change the
+ * modification time of the directory. Hence, sizes of locked directories and
+ * of directories containing a file modified in the last two seconds are not
+ * cached either.
+ */
+#define DIR_SIZES_FILE ".problem-sizes"
+
+struct cached_dir_size
+{
+    long long mtime_sec;
+    long mtime_nsec;
+    double size;
+};
+
+static GHashTable *load_dir_sizes(int dir_fd)
+{
+    GHashTable *sizes = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+
+    const int fd = openat(dir_fd, DIR_SIZES_FILE, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+        return sizes;
+
+    FILE *fp = fdopen(fd, "r");
+    if (fp == NULL)
+    {
+        close(fd);
+        return sizes;
+    }
+
+    char *line;
+    while ((line = xmalloc_fgetline(fp)) != NULL)
+    {
+        struct cached_dir_size *cs = xmalloc(sizeof(*cs));
+        int ofs = 0;
+        if (sscanf(line, "%lld %ld %lf %n", &cs->mtime_sec, &cs->mtime_nsec, &cs->size, &ofs) == 3
+         && line[ofs] != '\0')
+            g_hash_table_replace(sizes, xstrdup(line + ofs), cs);
+        else
+            free(cs);
+
+        free(line);
+    }
+
+    fclose(fp);
+    return sizes;
+}
+
+static void save_dir_sizes(const char *dirname, GHashTable *sizes)
+{
+    char *tmp_path = xasprintf("%s/"DIR_SIZES_FILE".XXXXXX", dirname);
+    const int fd = mkstemp(tmp_path);
+    if (fd < 0)
+    {
+        /* Not an error, unprivileged users can trim their own directories */
+        log_debug("Can't create '%s': %s", tmp_path, strerror(errno));
+        free(tmp_path);
+        return;
+    }
+
+    FILE *fp = fdopen(fd, "w");
+    if (fp == NULL)
+    {
+        close(fd);
+        goto cleanup;
+    }
+
+    GHashTableIter iter;
+    gpointer name;
+    gpointer value;
+    g_hash_table_iter_init(&iter, sizes);
+    while (g_hash_table_iter_next(&iter, &name, &value))
+    {
+        const struct cached_dir_size *cs = value;
+        fprintf(fp, "%lld %ld %.0f %s\n", cs->mtime_sec, cs->mtime_nsec, cs->size, (const char *)name);
+    }
+
+    if (fclose(fp) != 0)
+    {
+        perror_msg("Can't write '%s'", tmp_path);
+        goto cleanup;
+    }
+
+    char *path = concat_path_file(dirname, DIR_SIZES_FILE);
+    if (rename(tmp_path, path) != 0)
+        perror_msg("Can't rename '%s' to '%s'", tmp_path, path);
+    free(path);
+
+cleanup:
+    unlink(tmp_path);
+    free(tmp_path);
+}
+
+/* Returns the size of the files in the directory and its sub-directories
+ * and updates newest to the newest modification time of them. Closes dir_fd.
+ */
+static double measure_dir(int dir_fd, time_t *newest)
+{
+    DIR *dp = fdopendir(dir_fd);
+    if (dp == NULL)
+    {
+        close(dir_fd);
+        return 0;
+    }
+
+    double size = 0;
+    struct dirent *ep;
+    while ((ep = readdir(dp)) != NULL)
+    {
+        if (dot_or_dotdot(ep->d_name))
+            continue;
+
+        struct stat st;
+        if (fstatat(dirfd(dp), ep->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+            continue;
+
+        if (st.st_mtime > *newest)
+            *newest = st.st_mtime;
+
+        if (S_ISREG(st.st_mode))
+            size += st.st_size;
+        else if (S_ISDIR(st.st_mode))
+        {
+            const int fd = openat(dirfd(dp), ep->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (fd >= 0)
+                size += measure_dir(fd, newest);
+        }
+    }
+
+    closedir(dp);
+    return size;
+}
+
+static gint dir_size_weight_cmp(gconstpointer a, gconstpointer b)
+{
+    const double wa = ((const struct dir_size *)a)->weight;
+    const double wb = ((const struct dir_size *)b)->weight;
+    return wa < wb ? 1 : (wa > wb ? -1 : 0);
+}
+
+double get_dirsize_find_worst_dirs(const char *dirname, GList **worst_dirs, const char *excluded)
+{
+    if (worst_dirs)
+        *worst_dirs = NULL;
+
+    DIR *dp = opendir(dirname);
+    if (dp == NULL)
+        return 0;
+
+    GHashTable *cached = load_dir_sizes(dirfd(dp));
+    GHashTable *current = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+    unsigned reused = 0;
+    bool changed = false;
+
+    const time_t now = time(NULL);
+    double total = 0;
+    struct dirent *ep;
+    while ((ep = readdir(dp)) != NULL)
+    {
+        /* Do not count the cache, it is not a part of any problem */
+        if (dot_or_dotdot(ep->d_name) || prefixcmp(ep->d_name, DIR_SIZES_FILE) == 0)
+            continue;
+
+        struct stat st;
+        if (fstatat(dirfd(dp), ep->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+            continue;
+
+        if (S_ISREG(st.st_mode))
+        {
+            total += st.st_size;
+            continue;
+        }
+
+        if (!S_ISDIR(st.st_mode))
+            continue;
+
+        struct cached_dir_size cs;
+        bool cacheable = st.st_mtime < now - 1;
+        const struct cached_dir_size *old = g_hash_table_lookup(cached, ep->d_name);
+        if (old != NULL
+         && old->mtime_sec == (long long)st.st_mtim.tv_sec
+         && old->mtime_nsec == (long)st.st_mtim.tv_nsec)
+        {
+            cs = *old;
+            ++reused;
+        }
+        else
+        {
+            cs.mtime_sec = st.st_mtim.tv_sec;
+            cs.mtime_nsec = st.st_mtim.tv_nsec;
+            cs.size = 0;
+            changed = true;
+
+            const int fd = openat(dirfd(dp), ep->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (fd >= 0)
+            {
+                struct stat lock_st;
+                if (fstatat(fd, ".lock", &lock_st, AT_SYMLINK_NOFOLLOW) == 0)
+                    cacheable = false;
+
+                time_t newest = st.st_mtime;
+                cs.size = measure_dir(fd, &newest);
+                if (newest >= now - 1)
+                    cacheable = false;
+            }
+        }
+
+        if (cacheable)
+        {
+            struct cached_dir_size *copy = xmalloc(sizeof(*copy));
+            *copy = cs;
+            g_hash_table_replace(current, xstrdup(ep->d_name), copy);
+        }
+
+        total += cs.size;
+
+        if (worst_dirs == NULL || (excluded != NULL && strcmp(excluded, ep->d_name) == 0))
+            continue;
+
+        /* The same weight as libreport's get_dirsize_find_largest_dir() uses:
+         * w = sz_kbytes * age_mins */
+        struct dir_size *ds = xmalloc(sizeof(*ds) + strlen(ep->d_name) + 1);
+        ds->size = cs.size;
+        ds->weight = cs.size / 1024;
+        const long age = (now - st.st_mtime) / 60;
+        if (age > 0)
+            ds->weight *= age;
+        strcpy(ds->name, ep->d_name);
+
+        *worst_dirs = g_list_prepend(*worst_dirs, ds);
+    }
+    closedir(dp);
+
+    /* Some of the cached directories disappeared */
+    if (reused != g_hash_table_size(cached))
+        changed = true;
+
+    if (changed)
+        save_dir_sizes(dirname, current);
+
+    g_hash_table_destroy(current);
+    g_hash_table_destroy(cached);
+
+    if (worst_dirs)
+        *worst_dirs = g_list_sort(*worst_dirs, dir_size_weight_cmp);
+
+    return total;
+}
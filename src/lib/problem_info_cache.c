@@ -0,0 +1,949 @@
+/*
+    Copyright (C) 2016  ABRT Team
+    Copyright (C) 2016  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <sys/file.h>
+#include "internal_libabrt.h"
+
+/* The elements needed for listing problems and for duplicate detection are
+ * cached in a file in the dump location in order to avoid opening of every
+ * problem directory.
+ *
+ * The file starts with the header line followed by records:
+ *   DIR_MTIME_SEC DIR_MTIME_NSEC ITEMS_MTIME_SEC ITEMS_MTIME_NSEC DIRECTORY_NAME
+ *   ELEMENT=VALUE
+ *   ...
+ *   <empty line>
+ *
+ * and by annotations of problems:
+ *   @ DIRECTORY_NAME
+ *   NAME=VALUE
+ *   ...
+ *   <empty line>
+ *
+ * Back slashes and new lines in values are escaped.
+ *
+ * A record is up to date if the modification time of the directory is equal
+ * to the cached one. Locking of a dump directory changes the directory's
+ * modification time too, hence if the time does not match, the record is
+ * still up to date if none of the cached elements was created, deleted or
+ * modified after the newest cached element (ITEMS_MTIME).
+ *
+ * Modification times have a coarse granularity, so a change made shortly
+ * after caching could end up with the same time. Hence, records of elements
+ * modified in the last two seconds are not cached at all and a too recent
+ * modification time of a directory is not remembered.
+ *
+ * A record is trusted as a complete problem directory without locking, so
+ * directories being created ("<name>.new") and locked directories are never
+ * cached.
+ *
+ * Problems are looked up by values of cached elements through in-memory
+ * indexes mapping a value to the problems sorted by their last occurrence.
+ * An index of an element is built on the first look up and dropped whenever
+ * the set of cached records changes.
+ *
+ * Annotations are values computed by ABRT tools which are not problem
+ * elements, so they are never reported. They do not depend on the records,
+ * hence even problems which can't be cached yet can be annotated, and they
+ * are forgotten only when their problems are deleted.
+ *
+ * The file is replaced by rename(), so readers never see a partially written
+ * file. Writers load, modify and save the file under an exclusive flock() of
+ * a separate lock file, otherwise concurrent writers would lose each other's
+ * changes.
+ */
+#define PROBLEM_INFO_CACHE_FILE ".problem-info"
+#define PROBLEM_INFO_CACHE_LOCK_FILE ".problem-info.lock"
+#define PROBLEM_INFO_CACHE_HEADER "ABRT problem info cache 4"
+
+static const char *const s_cached_elements[] = {
+    FILENAME_TYPE,
+    FILENAME_TIME,
+    FILENAME_LAST_OCCURRENCE,
+    FILENAME_COUNT,
+    FILENAME_UID,
+    FILENAME_EXECUTABLE,
+    FILENAME_REASON,
+    FILENAME_PACKAGE,
+    FILENAME_COMPONENT,
+    FILENAME_NOT_REPORTABLE,
+    FILENAME_REPORTED_TO,
+    /* Needed by duplicate detection */
+    FILENAME_UUID,
+    /* Commonly looked up */
+    FILENAME_DUPHASH,
+    FILENAME_CMDLINE,
+};
+
+#define CACHED_ELEMENTS_COUNT ARRAY_SIZE(s_cached_elements)
+
+struct problem_info
+{
+    struct timespec pi_dir_mtime;
+    struct timespec pi_items_mtime;
+    char *pi_values[CACHED_ELEMENTS_COUNT];
+};
+
+struct problem_info_cache
+{
+    char *pic_dump_location;
+    GHashTable *pic_problems;
+    /* Names of problems which could not be cached by the last sync */
+    GPtrArray *pic_uncached;
+    GHashTable *pic_index[CACHED_ELEMENTS_COUNT];
+    /* Problem name -> (annotation name -> value) */
+    GHashTable *pic_annotations;
+    struct stat pic_file_stat;
+    /* Modification time of the dump location at the last sync */
+    struct timespec pic_location_mtime;
+    bool pic_loaded;
+    bool pic_dirty;
+};
+
+static int cached_element_index(const char *element)
+{
+    for (unsigned i = 0; i < CACHED_ELEMENTS_COUNT; ++i)
+        if (strcmp(s_cached_elements[i], element) == 0)
+            return i;
+
+    return -1;
+}
+
+static void problem_info_free(struct problem_info *pi)
+{
+    if (pi == NULL)
+        return;
+
+    for (unsigned i = 0; i < CACHED_ELEMENTS_COUNT; ++i)
+        free(pi->pi_values[i]);
+
+    free(pi);
+}
+
+static int timespec_cmp(const struct timespec *lhs, const struct timespec *rhs)
+{
+    if (lhs->tv_sec != rhs->tv_sec)
+        return lhs->tv_sec < rhs->tv_sec ? -1 : 1;
+
+    if (lhs->tv_nsec != rhs->tv_nsec)
+        return lhs->tv_nsec < rhs->tv_nsec ? -1 : 1;
+
+    return 0;
+}
+
+static bool is_too_recent(const struct timespec *ts)
+{
+    return ts->tv_sec >= time(NULL) - 1;
+}
+
+static void fputs_escaped(const char *value, FILE *fp)
+{
+    for (; *value != '\0'; ++value)
+    {
+        if (*value == '\\')
+            fputs("\\\\", fp);
+        else if (*value == '\n')
+            fputs("\\n", fp);
+        else
+            fputc(*value, fp);
+    }
+}
+
+static char *unescape(const char *value)
+{
+    char *result = xmalloc(strlen(value) + 1);
+    char *dst = result;
+    for (; *value != '\0'; ++value)
+    {
+        if (*value == '\\' && value[1] != '\0')
+            *dst++ = (*++value == 'n') ? '\n' : *value;
+        else
+            *dst++ = *value;
+    }
+    *dst = '\0';
+
+    return result;
+}
+
+/* An entry of an index, name points to a key of pic_problems */
+struct indexed_problem
+{
+    unsigned long ip_last_occurrence;
+    const char *ip_name;
+};
+
+static gint indexed_problem_cmp(gconstpointer a, gconstpointer b)
+{
+    const unsigned long la = ((const struct indexed_problem *)a)->ip_last_occurrence;
+    const unsigned long lb = ((const struct indexed_problem *)b)->ip_last_occurrence;
+    return la < lb ? -1 : (la > lb ? 1 : 0);
+}
+
+/* The same conversion as abrt-dbus has always used, a missing value is 0 */
+static unsigned long parse_last_occurrence(const char *value)
+{
+    return value != NULL ? (unsigned long)atol(value) : 0;
+}
+
+static void problem_info_cache_drop_index(problem_info_cache_t *cache)
+{
+    for (unsigned i = 0; i < CACHED_ELEMENTS_COUNT; ++i)
+    {
+        if (cache->pic_index[i] != NULL)
+            g_hash_table_destroy(cache->pic_index[i]);
+
+        cache->pic_index[i] = NULL;
+    }
+}
+
+/* Maps values of the element to arrays of problems sorted by their last
+ * occurrence. Missing elements are indexed as empty values. */
+static GHashTable *problem_info_cache_build_index(problem_info_cache_t *cache, int element)
+{
+    GHashTable *index = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                              NULL, (GDestroyNotify)g_array_unref);
+    const int last_occurrence = cached_element_index(FILENAME_LAST_OCCURRENCE);
+
+    GHashTableIter iter;
+    gpointer name;
+    gpointer value;
+    g_hash_table_iter_init(&iter, cache->pic_problems);
+    while (g_hash_table_iter_next(&iter, &name, &value))
+    {
+        const struct problem_info *pi = value;
+        const char *key = pi->pi_values[element] != NULL ? pi->pi_values[element] : "";
+
+        GArray *problems = g_hash_table_lookup(index, key);
+        if (problems == NULL)
+        {
+            problems = g_array_new(FALSE, FALSE, sizeof(struct indexed_problem));
+            g_hash_table_insert(index, (gpointer)key, problems);
+        }
+
+        struct indexed_problem ip = {
+            .ip_last_occurrence = parse_last_occurrence(pi->pi_values[last_occurrence]),
+            .ip_name = name,
+        };
+        g_array_append_val(problems, ip);
+    }
+
+    g_hash_table_iter_init(&iter, index);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+        g_array_sort((GArray *)value, indexed_problem_cmp);
+
+    return index;
+}
+
+problem_info_cache_t *problem_info_cache_new(const char *dump_location)
+{
+    problem_info_cache_t *cache = xzalloc(sizeof(*cache));
+    cache->pic_dump_location = xstrdup(dump_location);
+    cache->pic_problems = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                free, (GDestroyNotify)problem_info_free);
+    cache->pic_uncached = g_ptr_array_new_with_free_func(free);
+    cache->pic_annotations = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                   free, (GDestroyNotify)g_hash_table_destroy);
+    return cache;
+}
+
+void problem_info_cache_free(problem_info_cache_t *cache)
+{
+    if (cache == NULL)
+        return;
+
+    problem_info_cache_drop_index(cache);
+    g_ptr_array_free(cache->pic_uncached, TRUE);
+    g_hash_table_destroy(cache->pic_annotations);
+    g_hash_table_destroy(cache->pic_problems);
+    free(cache->pic_dump_location);
+    free(cache);
+}
+
+/* Re-reads the file only if it was replaced since the last call. */
+/* Returns true if the cache file was not replaced since it was loaded */
+static bool problem_info_cache_stat_file(problem_info_cache_t *cache, const char *path,
+                struct stat *st)
+{
+    /* Trust only a file written by the same user */
+    if (lstat(path, st) != 0 || !S_ISREG(st->st_mode) || st->st_uid != geteuid())
+        memset(st, 0, sizeof(*st));
+
+    return cache->pic_loaded
+        && st->st_ino == cache->pic_file_stat.st_ino
+        && st->st_dev == cache->pic_file_stat.st_dev
+        && st->st_size == cache->pic_file_stat.st_size
+        && timespec_cmp(&st->st_mtim, &cache->pic_file_stat.st_mtim) == 0;
+}
+
+static void problem_info_cache_load(problem_info_cache_t *cache)
+{
+    char *path = concat_path_file(cache->pic_dump_location, PROBLEM_INFO_CACHE_FILE);
+
+    struct stat st;
+    if (problem_info_cache_stat_file(cache, path, &st))
+        goto cleanup;
+
+    problem_info_cache_drop_index(cache);
+    g_hash_table_remove_all(cache->pic_problems);
+    g_hash_table_remove_all(cache->pic_annotations);
+    cache->pic_file_stat = st;
+    cache->pic_loaded = true;
+    cache->pic_dirty = false;
+
+    if (st.st_ino == 0)
+        goto cleanup;
+
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+        goto cleanup;
+
+    char *line = xmalloc_fgetline(fp);
+    if (line == NULL || strcmp(line, PROBLEM_INFO_CACHE_HEADER) != 0)
+    {
+        log_notice("Ignoring '%s': unknown format", path);
+        free(line);
+        fclose(fp);
+        goto cleanup;
+    }
+    free(line);
+
+    struct problem_info *pi = NULL;
+    GHashTable *annotations = NULL;
+    while ((line = xmalloc_fgetline(fp)) != NULL)
+    {
+        if (pi == NULL && annotations == NULL && prefixcmp(line, "@ ") == 0 && line[2] != '\0')
+        {
+            annotations = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+            g_hash_table_replace(cache->pic_annotations, xstrdup(line + 2), annotations);
+        }
+        else if (annotations != NULL)
+        {
+            char *value = strchr(line, '=');
+            if (line[0] == '\0')
+                annotations = NULL;
+            else if (value != NULL)
+            {
+                *value++ = '\0';
+                g_hash_table_replace(annotations, xstrdup(line), unescape(value));
+            }
+        }
+        else if (pi == NULL)
+        {
+            pi = xzalloc(sizeof(*pi));
+            long long dir_sec, items_sec;
+            long dir_nsec, items_nsec;
+            int ofs = 0;
+            if (sscanf(line, "%lld %ld %lld %ld %n", &dir_sec, &dir_nsec, &items_sec, &items_nsec, &ofs) == 4
+             && line[ofs] != '\0')
+            {
+                pi->pi_dir_mtime.tv_sec = dir_sec;
+                pi->pi_dir_mtime.tv_nsec = dir_nsec;
+                pi->pi_items_mtime.tv_sec = items_sec;
+                pi->pi_items_mtime.tv_nsec = items_nsec;
+                g_hash_table_replace(cache->pic_problems, xstrdup(line + ofs), pi);
+            }
+            else
+            {
+                /* Corrupted file, the rest of the file cannot be trusted */
+                log_notice("Ignoring corrupted record in '%s'", path);
+                free(pi);
+                free(line);
+                g_hash_table_remove_all(cache->pic_problems);
+                g_hash_table_remove_all(cache->pic_annotations);
+                break;
+            }
+        }
+        else if (line[0] == '\0')
+            pi = NULL;
+        else
+        {
+            char *value = strchr(line, '=');
+            if (value != NULL)
+            {
+                *value++ = '\0';
+                const int index = cached_element_index(line);
+                if (index >= 0)
+                {
+                    free(pi->pi_values[index]);
+                    pi->pi_values[index] = unescape(value);
+                }
+            }
+        }
+
+        free(line);
+    }
+
+    fclose(fp);
+
+cleanup:
+    free(path);
+}
+
+static void problem_info_cache_save(problem_info_cache_t *cache)
+{
+    char *tmp_path = xasprintf("%s/"PROBLEM_INFO_CACHE_FILE".XXXXXX", cache->pic_dump_location);
+    const int fd = mkstemp(tmp_path);
+    if (fd < 0)
+    {
+        log_debug("Can't create '%s': %s", tmp_path, strerror(errno));
+        free(tmp_path);
+        return;
+    }
+
+    FILE *fp = fdopen(fd, "w");
+    if (fp == NULL)
+    {
+        close(fd);
+        goto cleanup;
+    }
+
+    fputs(PROBLEM_INFO_CACHE_HEADER"\n", fp);
+
+    GHashTableIter iter;
+    gpointer name;
+    gpointer value;
+    g_hash_table_iter_init(&iter, cache->pic_problems);
+    while (g_hash_table_iter_next(&iter, &name, &value))
+    {
+        const struct problem_info *pi = value;
+        fprintf(fp, "%lld %ld %lld %ld %s\n",
+                (long long)pi->pi_dir_mtime.tv_sec, (long)pi->pi_dir_mtime.tv_nsec,
+                (long long)pi->pi_items_mtime.tv_sec, (long)pi->pi_items_mtime.tv_nsec,
+                (const char *)name);
+
+        for (unsigned i = 0; i < CACHED_ELEMENTS_COUNT; ++i)
+        {
+            if (pi->pi_values[i] == NULL)
+                continue;
+
+            fprintf(fp, "%s=", s_cached_elements[i]);
+            fputs_escaped(pi->pi_values[i], fp);
+            fputc('\n', fp);
+        }
+        fputc('\n', fp);
+    }
+
+    g_hash_table_iter_init(&iter, cache->pic_annotations);
+    while (g_hash_table_iter_next(&iter, &name, &value))
+    {
+        if (g_hash_table_size(value) == 0)
+            continue;
+
+        fprintf(fp, "@ %s\n", (const char *)name);
+
+        GHashTableIter annotation_iter;
+        gpointer annotation;
+        gpointer annotation_value;
+        g_hash_table_iter_init(&annotation_iter, value);
+        while (g_hash_table_iter_next(&annotation_iter, &annotation, &annotation_value))
+        {
+            fprintf(fp, "%s=", (const char *)annotation);
+            fputs_escaped(annotation_value, fp);
+            fputc('\n', fp);
+        }
+        fputc('\n', fp);
+    }
+
+    if (fclose(fp) != 0)
+    {
+        perror_msg("Can't write '%s'", tmp_path);
+        goto cleanup;
+    }
+
+    char *path = concat_path_file(cache->pic_dump_location, PROBLEM_INFO_CACHE_FILE);
+    if (rename(tmp_path, path) != 0)
+        perror_msg("Can't rename '%s' to '%s'", tmp_path, path);
+    else
+    {
+        /* Do not re-read the file we have just written */
+        if (stat(path, &cache->pic_file_stat) == 0)
+            cache->pic_dirty = false;
+    }
+    free(path);
+
+cleanup:
+    unlink(tmp_path);
+    free(tmp_path);
+}
+
+/* Returns a descriptor holding the lock or -1 if the file can't be written */
+static int problem_info_cache_lock(problem_info_cache_t *cache)
+{
+    char *path = concat_path_file(cache->pic_dump_location, PROBLEM_INFO_CACHE_LOCK_FILE);
+    int fd = open(path, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0)
+        log_debug("Can't open '%s': %s", path, strerror(errno));
+    else if (flock(fd, LOCK_EX) != 0)
+    {
+        log_debug("Can't lock '%s': %s", path, strerror(errno));
+        close(fd);
+        fd = -1;
+    }
+    free(path);
+    return fd;
+}
+
+static void problem_info_cache_unlock(int lock_fd)
+{
+    /* Releases the lock too */
+    if (lock_fd >= 0)
+        close(lock_fd);
+}
+
+struct element_stat
+{
+    bool exists;
+    ino_t ino;
+    struct timespec mtime;
+};
+
+static void stat_cached_elements(const char *dir_path, struct element_stat *stats)
+{
+    for (unsigned i = 0; i < CACHED_ELEMENTS_COUNT; ++i)
+    {
+        char *path = concat_path_file(dir_path, s_cached_elements[i]);
+        struct stat st;
+        stats[i].exists = lstat(path, &st) == 0;
+        stats[i].ino = stats[i].exists ? st.st_ino : 0;
+        if (stats[i].exists)
+            stats[i].mtime = st.st_mtim;
+        else
+            memset(&stats[i].mtime, 0, sizeof(stats[i].mtime));
+        free(path);
+    }
+}
+
+/* Returns true if the cached record matches the problem directory. */
+static bool problem_info_is_up_to_date(problem_info_cache_t *cache,
+                const char *dir_path, struct problem_info *pi)
+{
+    struct stat st;
+    if (lstat(dir_path, &st) != 0 || !S_ISDIR(st.st_mode))
+        return false;
+
+    if (timespec_cmp(&st.st_mtim, &pi->pi_dir_mtime) == 0)
+        return true;
+
+    struct element_stat stats[CACHED_ELEMENTS_COUNT];
+    stat_cached_elements(dir_path, stats);
+
+    for (unsigned i = 0; i < CACHED_ELEMENTS_COUNT; ++i)
+    {
+        if (stats[i].exists != (pi->pi_values[i] != NULL))
+            return false;
+
+        if (stats[i].exists && timespec_cmp(&stats[i].mtime, &pi->pi_items_mtime) > 0)
+            return false;
+    }
+
+    /* The directory was modified by something else than the cached
+     * elements, remember the new time to make the next check cheap. */
+    if (!is_too_recent(&st.st_mtim))
+    {
+        pi->pi_dir_mtime = st.st_mtim;
+        cache->pic_dirty = true;
+    }
+    return true;
+}
+
+/* The lock of a dump directory is a symbolic link in the directory */
+static bool is_locked(const char *dir_path)
+{
+    char *lock_path = concat_path_file(dir_path, ".lock");
+    struct stat st;
+    const bool locked = lstat(lock_path, &st) == 0;
+    free(lock_path);
+    return locked;
+}
+
+static bool is_being_created(const char *name)
+{
+    const char *ext = strrchr(name, '.');
+    return ext != NULL && strcmp(ext, ".new") == 0;
+}
+
+static struct problem_info *problem_info_read(const char *dir_path)
+{
+    /* The directory must be checked before the elements, so every later
+     * modification makes the record out of date. */
+    struct stat st;
+    if (lstat(dir_path, &st) != 0 || !S_ISDIR(st.st_mode))
+        return NULL;
+
+    /* The elements of a directory being created or locked may be incomplete */
+    if (is_being_created(dir_path))
+        return NULL;
+
+    if (is_locked(dir_path))
+    {
+        log_debug("'%s' is locked, not caching it", dir_path);
+        return NULL;
+    }
+
+    struct element_stat before[CACHED_ELEMENTS_COUNT];
+    stat_cached_elements(dir_path, before);
+
+    /* Locking would change the modification time of the directory, the
+     * elements are checked for concurrent modifications below instead. */
+    struct dump_dir *dd = dd_opendir(dir_path,   DD_OPEN_FD_ONLY
+                                               | DD_FAIL_QUIETLY_ENOENT
+                                               | DD_FAIL_QUIETLY_EACCES);
+    if (dd == NULL)
+        return NULL;
+
+    struct problem_info *pi = xzalloc(sizeof(*pi));
+    for (unsigned i = 0; i < CACHED_ELEMENTS_COUNT; ++i)
+    {
+        if (!before[i].exists)
+            continue;
+
+        pi->pi_values[i] = dd_load_text_ext(dd, s_cached_elements[i],   DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE
+                                                                      | DD_FAIL_QUIETLY_ENOENT
+                                                                      | DD_FAIL_QUIETLY_EACCES);
+        if (timespec_cmp(&before[i].mtime, &pi->pi_items_mtime) > 0)
+            pi->pi_items_mtime = before[i].mtime;
+    }
+    dd_close(dd);
+
+    if (is_too_recent(&pi->pi_items_mtime))
+    {
+        log_debug("'%s' is too recent to be cached", dir_path);
+        goto discard;
+    }
+
+    if (!is_too_recent(&st.st_mtim))
+        pi->pi_dir_mtime = st.st_mtim;
+
+    if (is_locked(dir_path))
+    {
+        log_debug("'%s' was locked while being cached", dir_path);
+        goto discard;
+    }
+
+    struct element_stat after[CACHED_ELEMENTS_COUNT];
+    stat_cached_elements(dir_path, after);
+    for (unsigned i = 0; i < CACHED_ELEMENTS_COUNT; ++i)
+    {
+        if (before[i].exists != after[i].exists
+         || before[i].ino != after[i].ino
+         || timespec_cmp(&before[i].mtime, &after[i].mtime) != 0
+         || (before[i].exists && pi->pi_values[i] == NULL))
+        {
+            log_debug("'%s' was modified while being cached", dir_path);
+            goto discard;
+        }
+    }
+
+    return pi;
+
+discard:
+    problem_info_free(pi);
+    return NULL;
+}
+
+/* Returns the name of the problem directory in the dump location or NULL. */
+static const char *problem_name(problem_info_cache_t *cache, const char *problem_dir)
+{
+    const char *name = problem_dir;
+    const size_t len = strlen(cache->pic_dump_location);
+    if (problem_dir[0] == '/')
+    {
+        if (strncmp(problem_dir, cache->pic_dump_location, len) != 0 || problem_dir[len] != '/')
+            return NULL;
+
+        name = problem_dir + len + 1;
+    }
+
+    if (strchr(name, '/') != NULL || dot_or_dotdot(name))
+        return NULL;
+
+    return name;
+}
+
+const problem_info_t *problem_info_cache_lookup(problem_info_cache_t *cache, const char *problem_dir)
+{
+    const char *name = problem_name(cache, problem_dir);
+    if (name == NULL || is_being_created(name))
+        return NULL;
+
+    problem_info_cache_load(cache);
+
+    struct problem_info *pi = g_hash_table_lookup(cache->pic_problems, name);
+    if (pi == NULL)
+        return NULL;
+
+    char *dir_path = concat_path_file(cache->pic_dump_location, name);
+    const bool up_to_date = problem_info_is_up_to_date(cache, dir_path, pi);
+    free(dir_path);
+
+    return up_to_date ? pi : NULL;
+}
+
+bool problem_info_get_item(const problem_info_t *pi, const char *element, const char **value)
+{
+    const int index = cached_element_index(element);
+    if (index < 0)
+        return false;
+
+    *value = pi->pi_values[index];
+    return true;
+}
+
+const char *problem_info_cache_get_annotation(problem_info_cache_t *cache, const char *problem_dir,
+                const char *name)
+{
+    const char *problem = problem_name(cache, problem_dir);
+    if (problem == NULL)
+        return NULL;
+
+    problem_info_cache_load(cache);
+
+    GHashTable *annotations = g_hash_table_lookup(cache->pic_annotations, problem);
+    return annotations != NULL ? g_hash_table_lookup(annotations, name) : NULL;
+}
+
+void problem_info_cache_annotate(problem_info_cache_t *cache, const char *problem_dir,
+                const char *name, const char *value)
+{
+    const char *problem = problem_name(cache, problem_dir);
+    if (problem == NULL)
+        return;
+
+    const int lock_fd = problem_info_cache_lock(cache);
+    if (lock_fd < 0)
+        return;
+
+    problem_info_cache_load(cache);
+
+    GHashTable *annotations = g_hash_table_lookup(cache->pic_annotations, problem);
+    if (annotations == NULL)
+    {
+        annotations = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+        g_hash_table_replace(cache->pic_annotations, xstrdup(problem), annotations);
+    }
+    g_hash_table_replace(annotations, xstrdup(name), xstrdup(value));
+
+    problem_info_cache_save(cache);
+    problem_info_cache_unlock(lock_fd);
+}
+
+int problem_info_cache_sync(problem_info_cache_t *cache)
+{
+    /* Taken before reading the directory, so that problems created while
+     * reading it cause the next sync */
+    struct stat location_st;
+    if (stat(cache->pic_dump_location, &location_st) != 0)
+        return -errno;
+
+    DIR *dp = opendir(cache->pic_dump_location);
+    if (dp == NULL)
+        return -errno;
+
+    /* Users who can't write the file still get up to date records */
+    const int lock_fd = problem_info_cache_lock(cache);
+
+    problem_info_cache_load(cache);
+    g_ptr_array_set_size(cache->pic_uncached, 0);
+
+    GHashTable *seen = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    unsigned cached = 0;
+
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        if (dot_or_dotdot(dent->d_name) || dent->d_name[0] == '.')
+            continue;
+
+        if (dent->d_type != DT_DIR && dent->d_type != DT_UNKNOWN)
+            continue;
+
+        char *dir_path = concat_path_file(cache->pic_dump_location, dent->d_name);
+
+        struct problem_info *pi = g_hash_table_lookup(cache->pic_problems, dent->d_name);
+        if (pi == NULL || !problem_info_is_up_to_date(cache, dir_path, pi))
+        {
+            const bool was_cached = pi != NULL;
+            pi = problem_info_read(dir_path);
+            if (pi != NULL)
+                g_hash_table_replace(cache->pic_problems, xstrdup(dent->d_name), pi);
+            else
+                g_hash_table_remove(cache->pic_problems, dent->d_name);
+
+            /* Problems which cannot be cached yet do not change anything */
+            if (pi != NULL || was_cached)
+            {
+                problem_info_cache_drop_index(cache);
+                cache->pic_dirty = true;
+            }
+        }
+
+        g_hash_table_add(seen, xstrdup(dent->d_name));
+        if (pi != NULL)
+            ++cached;
+        else
+            g_ptr_array_add(cache->pic_uncached, xstrdup(dent->d_name));
+
+        free(dir_path);
+    }
+    closedir(dp);
+
+    /* Forget deleted problems */
+    if (cached != g_hash_table_size(cache->pic_problems))
+    {
+        GHashTableIter iter;
+        gpointer name;
+        g_hash_table_iter_init(&iter, cache->pic_problems);
+        while (g_hash_table_iter_next(&iter, &name, NULL))
+        {
+            if (!g_hash_table_contains(seen, name))
+                g_hash_table_iter_remove(&iter);
+        }
+        problem_info_cache_drop_index(cache);
+        cache->pic_dirty = true;
+    }
+
+    GHashTableIter iter;
+    gpointer name;
+    g_hash_table_iter_init(&iter, cache->pic_annotations);
+    while (g_hash_table_iter_next(&iter, &name, NULL))
+    {
+        if (!g_hash_table_contains(seen, name))
+        {
+            g_hash_table_iter_remove(&iter);
+            cache->pic_dirty = true;
+        }
+    }
+    g_hash_table_destroy(seen);
+
+    if (cache->pic_dirty && lock_fd >= 0)
+        problem_info_cache_save(cache);
+
+    problem_info_cache_unlock(lock_fd);
+
+    if (is_too_recent(&location_st.st_mtim))
+        memset(&cache->pic_location_mtime, 0, sizeof(cache->pic_location_mtime));
+    else
+        cache->pic_location_mtime = location_st.st_mtim;
+
+    return 0;
+}
+
+/* Problems are created and deleted only by abrtd and abrtd syncs the cache
+ * file after every change. Hence, the cache needs to be synced only if
+ * a problem was created or deleted (the dump location was modified) or if
+ * somebody else synced the cache file.
+ */
+static int problem_info_cache_refresh(problem_info_cache_t *cache)
+{
+    struct stat st;
+    if (stat(cache->pic_dump_location, &st) != 0)
+        return -errno;
+
+    if (timespec_cmp(&st.st_mtim, &cache->pic_location_mtime) != 0)
+        return problem_info_cache_sync(cache);
+
+    char *path = concat_path_file(cache->pic_dump_location, PROBLEM_INFO_CACHE_FILE);
+    struct stat file_st;
+    const bool unchanged = problem_info_cache_stat_file(cache, path, &file_st);
+    free(path);
+
+    return unchanged ? 0 : problem_info_cache_sync(cache);
+}
+
+/* Problems which could not be cached must be read directly. */
+static bool problem_dir_matches(const char *dir_path, const char *element, const char *value,
+                unsigned long from, unsigned long to)
+{
+    struct dump_dir *dd = dd_opendir(dir_path,   DD_OPEN_READONLY
+                                               | DD_DONT_WAIT_FOR_LOCK
+                                               | DD_FAIL_QUIETLY_ENOENT
+                                               | DD_FAIL_QUIETLY_EACCES);
+    if (dd == NULL)
+        return false;
+
+    const int flags = DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE | DD_FAIL_QUIETLY_ENOENT | DD_FAIL_QUIETLY_EACCES;
+    char *data = dd_load_text_ext(dd, element, flags);
+    bool matches = strcmp(data != NULL ? data : "", value) == 0;
+    free(data);
+
+    if (matches)
+    {
+        data = dd_load_text_ext(dd, FILENAME_LAST_OCCURRENCE, flags);
+        const unsigned long last_occurrence = parse_last_occurrence(data);
+        free(data);
+        matches = from <= last_occurrence && last_occurrence <= to;
+    }
+
+    dd_close(dd);
+    return matches;
+}
+
+int problem_info_cache_find(problem_info_cache_t *cache, const char *element, const char *value,
+                unsigned long from, unsigned long to, GList **problems)
+{
+    *problems = NULL;
+
+    const int element_index = cached_element_index(element);
+    if (element_index < 0)
+        return -EINVAL;
+
+    const int r = problem_info_cache_refresh(cache);
+    if (r != 0)
+        return r;
+
+    if (cache->pic_index[element_index] == NULL)
+        cache->pic_index[element_index] = problem_info_cache_build_index(cache, element_index);
+
+    GArray *indexed = g_hash_table_lookup(cache->pic_index[element_index], value);
+    if (indexed != NULL)
+    {
+        /* Find the first problem which did not last occur before 'from' */
+        guint lo = 0;
+        guint hi = indexed->len;
+        while (lo < hi)
+        {
+            const guint mid = lo + (hi - lo) / 2;
+            if (g_array_index(indexed, struct indexed_problem, mid).ip_last_occurrence < from)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        for (; lo < indexed->len; ++lo)
+        {
+            const struct indexed_problem *ip = &g_array_index(indexed, struct indexed_problem, lo);
+            if (ip->ip_last_occurrence > to)
+                break;
+
+            *problems = g_list_prepend(*problems, concat_path_file(cache->pic_dump_location, ip->ip_name));
+        }
+    }
+
+    for (guint i = 0; i < cache->pic_uncached->len; ++i)
+    {
+        char *dir_path = concat_path_file(cache->pic_dump_location, g_ptr_array_index(cache->pic_uncached, i));
+        if (problem_dir_matches(dir_path, element, value, from, to))
+            *problems = g_list_prepend(*problems, dir_path);
+        else
+            free(dir_path);
+    }
+
+    *problems = g_list_reverse(*problems);
+    return 0;
+}
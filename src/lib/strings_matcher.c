@@ -0,0 +1,156 @@
+/*
+    Copyright (C) 2016  ABRT Team
+    Copyright (C) 2016  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "internal_libabrt.h"
+
+/* Aho-Corasick automaton finding the strings in a single pass over the text
+ * instead of calling strstr() for every string.
+ *
+ * The automaton is compiled to a DFA, so every byte of the text costs one
+ * table lookup. In order to keep the table small, the DFA works on classes
+ * of bytes: every byte occurring in the strings has its own class and all
+ * other bytes share the class 0 which always leads back to the root state.
+ */
+struct strings_matcher
+{
+    unsigned char byte_class[256];
+    unsigned class_count;
+    unsigned state_count;
+    /* state_count * class_count transitions */
+    unsigned *next;
+    /* Index of the string found when the state is entered or -1 */
+    int *found;
+    char **strings;
+};
+
+strings_matcher_t *strings_matcher_new(GList *strings)
+{
+    strings_matcher_t *matcher = xzalloc(sizeof(*matcher));
+
+    const unsigned string_count = g_list_length(strings);
+    matcher->strings = xmalloc(sizeof(matcher->strings[0]) * (string_count + 1));
+
+    unsigned max_states = 1;
+    unsigned i = 0;
+    for (GList *iter = strings; iter != NULL; iter = g_list_next(iter), ++i)
+    {
+        matcher->strings[i] = xstrdup(iter->data);
+        for (const unsigned char *c = iter->data; *c; ++c)
+        {
+            if (matcher->byte_class[*c] == 0)
+                matcher->byte_class[*c] = ++matcher->class_count;
+            ++max_states;
+        }
+    }
+    matcher->strings[string_count] = NULL;
+    ++matcher->class_count;
+
+    const unsigned cc = matcher->class_count;
+    matcher->next = xzalloc(sizeof(matcher->next[0]) * max_states * cc);
+    matcher->found = xmalloc(sizeof(matcher->found[0]) * max_states);
+    for (unsigned s = 0; s < max_states; ++s)
+        matcher->found[s] = -1;
+
+    /* Build a trie of the strings, no edge leads to the root state 0, hence
+     * 0 stands for a missing edge */
+    matcher->state_count = 1;
+    for (i = 0; i < string_count; ++i)
+    {
+        unsigned state = 0;
+        for (const unsigned char *c = (unsigned char *)matcher->strings[i]; *c; ++c)
+        {
+            unsigned *edge = &matcher->next[state * cc + matcher->byte_class[*c]];
+            if (*edge == 0)
+                *edge = matcher->state_count++;
+            state = *edge;
+        }
+
+        if (matcher->found[state] < 0)
+            matcher->found[state] = i;
+    }
+
+    /* Add the failure transitions in breadth-first order, the failure state
+     * of a state is the state of its longest proper suffix and is always
+     * shallower, so its transitions are already complete */
+    unsigned *fail = xzalloc(sizeof(fail[0]) * matcher->state_count);
+    unsigned *queue = xmalloc(sizeof(queue[0]) * matcher->state_count);
+    unsigned head = 0;
+    unsigned tail = 0;
+    queue[tail++] = 0;
+    while (head < tail)
+    {
+        const unsigned state = queue[head++];
+        for (unsigned c = 0; c < cc; ++c)
+        {
+            unsigned *edge = &matcher->next[state * cc + c];
+            const unsigned fallback = state == 0 ? 0 : matcher->next[fail[state] * cc + c];
+
+            /* The class 0 never starts an edge of the trie */
+            if (*edge == 0 || c == 0)
+            {
+                *edge = fallback;
+                continue;
+            }
+
+            fail[*edge] = fallback;
+            /* A string ending in the failure state ends here too */
+            if (matcher->found[*edge] < 0)
+                matcher->found[*edge] = matcher->found[fallback];
+
+            queue[tail++] = *edge;
+        }
+    }
+
+    free(queue);
+    free(fail);
+
+    return matcher;
+}
+
+void strings_matcher_free(strings_matcher_t *matcher)
+{
+    if (matcher == NULL)
+        return;
+
+    for (char **str = matcher->strings; *str; ++str)
+        free(*str);
+
+    free(matcher->strings);
+    free(matcher->found);
+    free(matcher->next);
+    free(matcher);
+}
+
+const char *strings_matcher_find(const strings_matcher_t *matcher, const char *text)
+{
+    /* An empty string is found in every text */
+    unsigned state = 0;
+    if (matcher->found[state] >= 0)
+        return matcher->strings[matcher->found[state]];
+
+    const unsigned cc = matcher->class_count;
+    for (const unsigned char *c = (const unsigned char *)text; *c; ++c)
+    {
+        state = matcher->next[state * cc + matcher->byte_class[*c]];
+        if (matcher->found[state] >= 0)
+            return matcher->strings[matcher->found[state]];
+    }
+
+    return NULL;
+}
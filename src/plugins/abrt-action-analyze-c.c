@@ -171,11 +171,19 @@ int main(int argc, char **argv)
     export_abrt_envvars(0);
 
     char *unstrip_n_output = NULL;
+    /* Do not decompress the core dump if it is not necessary */
+    int unpacked = 0;
+    char *core_backtrace_path = xasprintf("%s/"FILENAME_CORE_BACKTRACE, dump_dir_name);
+    if (access(core_backtrace_path, R_OK) != 0)
+        unpacked = unpack_compressed_coredump(dump_dir_name);
+    free(core_backtrace_path);
+
     char *coredump_path = xasprintf("%s/"FILENAME_COREDUMP, dump_dir_name);
     if (access(coredump_path, R_OK) == 0)
         unstrip_n_output = run_unstrip_n(dump_dir_name, /*timeout_sec:*/ 30);
 
     free(coredump_path);
+    remove_unpacked_coredump(dump_dir_name, unpacked);
 
     if (unstrip_n_output)
     {
@@ -66,6 +66,9 @@ int main(int argc, char **argv)
     char *error_message = NULL;
     bool success;
 
+    /* Neither satyr nor GDB can read compressed core dumps */
+    const int unpacked = unpack_compressed_coredump(dump_dir_name);
+
 #ifdef ENABLE_NATIVE_UNWINDER
 
     success = sr_abrt_create_core_stacktrace(dump_dir_name, !raw_fingerprints,
@@ -79,6 +82,7 @@ int main(int argc, char **argv)
     if (!gdb_output)
     {
         log(_("Error: GDB did not return any data"));
+        remove_unpacked_coredump(dump_dir_name, unpacked);
         return 1;
     }
 
@@ -90,6 +94,8 @@ int main(int argc, char **argv)
 
 #endif /* ENABLE_NATIVE_UNWINDER */
 
+    remove_unpacked_coredump(dump_dir_name, unpacked);
+
     if (!success)
     {
         log(_("Error: %s"), error_message);
@@ -12,10 +12,14 @@
  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
  * GNU General Public License for more details.
  */
+#include <sys/ioctl.h>
+#include <linux/fs.h>
 #include "libabrt.h"
 #include "abrt-journal.h"
 
 #define ABRT_JOURNAL_WATCH_STATE_FILE VAR_STATE"/abrt-dump-journal-core.state"
+#define ABRT_JOURNAL_THROTTLE_STATE_FILE VAR_STATE"/abrt-dump-journal-core.throttle"
+#define ABRT_JOURNAL_THROTTLE_TABLE_SIZE 1024
 
 /*
  * A journal message is a set of key value pairs in the following format:
@@ -77,95 +81,187 @@ struct crash_info
 };
 
 /*
- * ABRT watch core configuration
+ * A table of per-executable token buckets.
+ *
+ * Every executable has a bucket holding up to tt_burst tokens which is
+ * refilled with tt_burst tokens per tt_window seconds. A crash takes one
+ * token and crashes finding their bucket empty are throttled.
+ *
+ * The buckets are stored in a hash table and the least recently crashed
+ * executable is forgotten when the table has tt_max_size entries. The table
+ * is saved in a file in the same format as the ccpp hook's crash rate file.
  */
-typedef struct
+struct throttle_entry
 {
-    const char *awc_dump_location;
-    int awc_throttle;
+    struct abrt_crash_rate_bucket te_bucket;
+    GList te_lru_link;        ///< te_lru_link.data points to the executable
+};
+
+struct throttle_table
+{
+    GHashTable *tt_entries;   ///< executable -> struct throttle_entry
+    GQueue tt_lru;            ///< the most recently crashed executable first
+    unsigned tt_max_size;
+    unsigned tt_burst;
+    unsigned tt_window;
+    const char *tt_file_name;
+};
+
+static void
+throttle_table_init(struct throttle_table *table, unsigned max_size, unsigned burst, unsigned window)
+{
+    table->tt_entries = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+    g_queue_init(&table->tt_lru);
+    table->tt_max_size = max_size > 0 ? max_size : 1;
+    table->tt_burst = burst;
+    table->tt_window = window;
+    table->tt_file_name = NULL;
 }
-abrt_watch_core_conf_t;
 
+static void
+throttle_table_destroy(struct throttle_table *table)
+{
+    /* The queue links are embedded in the entries */
+    g_hash_table_destroy(table->tt_entries);
+    g_queue_init(&table->tt_lru);
+}
+
+static bool
+throttle_table_enabled(const struct throttle_table *table)
+{
+    return table->tt_burst > 0 && table->tt_window > 0;
+}
+
+static struct throttle_entry *
+throttle_table_get(struct throttle_table *table, const char *executable, long long now)
+{
+    struct throttle_entry *e = g_hash_table_lookup(table->tt_entries, executable);
+    if (e != NULL)
+    {
+        g_queue_unlink(&table->tt_lru, &e->te_lru_link);
+        g_queue_push_head_link(&table->tt_lru, &e->te_lru_link);
+        return e;
+    }
+
+    if (g_hash_table_size(table->tt_entries) >= table->tt_max_size)
+    {   /* Forget the executable which has not crashed for the longest time */
+        GList *oldest = g_queue_pop_tail_link(&table->tt_lru);
+        log_debug("Forgetting crash rate of '%s'", (const char *)oldest->data);
+        g_hash_table_remove(table->tt_entries, oldest->data);
+    }
+
+    e = xzalloc(sizeof(*e));
+    crash_rate_bucket_init(&e->te_bucket, table->tt_burst, now);
+
+    char *key = xstrdup(executable);
+    e->te_lru_link.data = key;
+    g_hash_table_insert(table->tt_entries, key, e);
+    g_queue_push_head_link(&table->tt_lru, &e->te_lru_link);
+
+    return e;
+}
 
 /*
- * A helper structured holding executable name and its last occurrence time.
+ * Takes a token from the bucket of the executable.
  *
- * It is rather an array than a queue. Ii uses statically allocated array and
- * the head member points the next position for creating a new entry (the next
- * position may be already occupied and in such case the data shall be released).
+ * Returns true if the crash shall be throttled. The suppressed argument is
+ * set to the number of throttled crashes since the last not throttled one.
  */
-struct occurrence_queue
+static bool
+throttle_table_check(struct throttle_table *table, const char *executable, long long now, unsigned *suppressed)
 {
-    int oq_head;       ///< the first empty index
-    unsigned oq_size;  ///< size of the queue
-
-    struct last_occurence
-    {
-        unsigned oqlc_stamp;
-        char *oqlc_executable;
-    } oq_occurrences[8];
+    *suppressed = 0;
+    if (!throttle_table_enabled(table))
+        return false;
 
-} s_queue = {
-    .oq_head = -1,
-    .oq_size = 8,
-};
+    struct throttle_entry *e = throttle_table_get(table, executable, now);
+    return crash_rate_bucket_take(&e->te_bucket, table->tt_burst, table->tt_window, now, suppressed);
+}
 
-static unsigned
-abrt_journal_get_last_occurrence(const char *executable)
+static void
+throttle_table_load(struct throttle_table *table, const char *file_name)
 {
-    if (s_queue.oq_head < 0)
-        return 0;
+    table->tt_file_name = file_name;
 
-    unsigned index = s_queue.oq_head == 0 ? s_queue.oq_size - 1 : s_queue.oq_head - 1;
-    for (unsigned i = 0; i < s_queue.oq_size; ++i)
+    FILE *fp = fopen(file_name, "r");
+    if (fp == NULL)
     {
-        if (s_queue.oq_occurrences[index].oqlc_executable == NULL)
-            break;
+        if (errno != ENOENT)
+            perror_msg("Can't open '%s'", file_name);
+        return;
+    }
+
+    /* The file starts with the most recently crashed executable */
+    struct abrt_crash_rate_bucket bucket;
+    char *executable;
+    while (g_hash_table_size(table->tt_entries) < table->tt_max_size
+           && (executable = crash_rate_read_entry(fp, file_name, &bucket)) != NULL)
+    {
+        if (g_hash_table_contains(table->tt_entries, executable))
+        {
+            log_notice("Ignoring duplicate line in '%s'", file_name);
+            free(executable);
+            continue;
+        }
 
-        if (strcmp(executable, s_queue.oq_occurrences[index].oqlc_executable) == 0)
-            return s_queue.oq_occurrences[index].oqlc_stamp;
+        struct throttle_entry *e = throttle_table_get(table, executable, bucket.last_update);
+        e->te_bucket = bucket;
+        /* Keep the order of the file */
+        g_queue_unlink(&table->tt_lru, &e->te_lru_link);
+        g_queue_push_tail_link(&table->tt_lru, &e->te_lru_link);
 
-        if (index-- == 0)
-            index = s_queue.oq_size - 1;
+        free(executable);
     }
 
-    return 0;
+    fclose(fp);
 }
 
 static void
-abrt_journal_update_occurrence(const char *executable, unsigned ts)
+throttle_table_save(struct throttle_table *table)
 {
-    if (s_queue.oq_head < 0)
-        s_queue.oq_head = 0;
-    else
+    if (table->tt_file_name == NULL || !throttle_table_enabled(table))
+        return;
+
+    char *tmp_name = xasprintf("%s.new", table->tt_file_name);
+    FILE *fp = fopen(tmp_name, "w");
+    if (fp == NULL)
     {
-        unsigned index = s_queue.oq_head == 0 ? s_queue.oq_size - 1 : s_queue.oq_head - 1;
-        for (unsigned i = 0; i < s_queue.oq_size; ++i)
-        {
-            if (s_queue.oq_occurrences[index].oqlc_executable == NULL)
-                break;
-
-            if (strcmp(executable, s_queue.oq_occurrences[index].oqlc_executable) == 0)
-            {
-                /* Enhancement: move this entry right behind head */
-                s_queue.oq_occurrences[index].oqlc_stamp = ts;
-                return;
-            }
-
-            if (index-- == 0)
-                index = s_queue.oq_size - 1;
-        }
+        perror_msg("Can't open '%s'", tmp_name);
+        goto cleanup;
     }
 
-    s_queue.oq_occurrences[s_queue.oq_head].oqlc_stamp = ts;
-    free(s_queue.oq_occurrences[s_queue.oq_head].oqlc_executable);
-    s_queue.oq_occurrences[s_queue.oq_head].oqlc_executable = xstrdup(executable);
+    for (GList *l = table->tt_lru.head; l != NULL; l = g_list_next(l))
+    {
+        const struct throttle_entry *e = g_hash_table_lookup(table->tt_entries, l->data);
+        crash_rate_write_entry(fp, (const char *)l->data, &e->te_bucket);
+    }
 
-    if (++s_queue.oq_head >= s_queue.oq_size)
-        s_queue.oq_head = 0;
+    if (fclose(fp) != 0)
+    {
+        perror_msg("Can't write '%s'", tmp_name);
+        unlink(tmp_name);
+        goto cleanup;
+    }
 
-    return;
+    if (rename(tmp_name, table->tt_file_name) != 0)
+    {
+        perror_msg("Can't rename '%s' to '%s'", tmp_name, table->tt_file_name);
+        unlink(tmp_name);
+    }
+
+cleanup:
+    free(tmp_name);
+}
+
+/*
+ * ABRT watch core configuration
+ */
+typedef struct
+{
+    const char *awc_dump_location;
+    struct throttle_table *awc_throttle;
 }
+abrt_watch_core_conf_t;
 
 /*
  * Converts a journal message into an intermediate ABRT problem (struct crash_info).
@@ -239,6 +335,74 @@ abrt_journal_core_retrieve_information(abrt_journal_t *journal, struct crash_inf
     return 0;
 }
 
+/*
+ * How core dump files stored by systemd-coredump get to problem directories
+ * (see SystemdCoredumpAdoption in CCpp.conf).
+ *
+ * copy    - the core dump is copied and decompressed
+ * reflink - the core dump is cloned by FICLONE, the compressed core dump is
+ *           kept compressed and decompressed when a tool needs the raw one;
+ *           falls back to copying
+ *
+ * The file is never hard linked, the problem directory's items are chowned
+ * and chmoded and a shared inode would change the systemd-coredump file too.
+ */
+enum coredump_adoption
+{
+    COREDUMP_ADOPTION_COPY,
+    COREDUMP_ADOPTION_REFLINK,
+};
+
+static enum coredump_adoption s_coredump_adoption = COREDUMP_ADOPTION_COPY;
+
+/* Compressed core dumps as systemd-coredump names them */
+static const struct
+{
+    const char *suffix;
+    const char *item;
+} s_systemd_compressed_coredumps[] = {
+    { ".xz",  FILENAME_COREDUMP_XZ  },
+    { ".lz4", FILENAME_COREDUMP_LZ4 },
+    { ".zst", FILENAME_COREDUMP_ZST },
+};
+
+/*
+ * Clones the file into the problem directory.
+ *
+ * Returns 0 on success; otherwise -1 and the caller shall copy the file.
+ */
+static int
+adopt_systemd_coredump(struct dump_dir *dd, const char *item, const char *coredump_path)
+{
+#ifdef FICLONE
+    const int src_fd = open(coredump_path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (src_fd < 0)
+    {
+        perror_msg("Can't open '%s'", coredump_path);
+        return -1;
+    }
+
+    const int dst_fd = dd_open_item(dd, item, O_RDWR);
+    if (dst_fd >= 0)
+    {
+        const int r = ioctl(dst_fd, FICLONE, src_fd);
+        const int err = errno;
+        close(dst_fd);
+        if (r == 0)
+        {
+            close(src_fd);
+            return 0;
+        }
+
+        log_info("Can't clone '%s': %s", coredump_path, strerror(err));
+        dd_delete_item(dd, item);
+    }
+    close(src_fd);
+#endif
+
+    return -1;
+}
+
 /*
  * Initializes ABRT problem directory and save the relevant journal message
  * fileds in that directory.
@@ -251,23 +415,41 @@ save_systemd_coredump_in_dump_directory(struct dump_dir *dd, struct crash_info *
         log_debug("Processing coredumpctl entry without a real file");
 
     const size_t len = strlen(coredump_path);
-    if (   (len >= 3
-            && coredump_path[len - 3] == '.'
-            && coredump_path[len - 2] == 'x'
-            && coredump_path[len - 1] == 'z')
-        || (len >= 4
-            && coredump_path[len - 4] == '.'
-            && coredump_path[len - 3] == 'l'
-            && coredump_path[len - 2] == 'z'
-            && coredump_path[len - 1] == '4'))
+    const char *item = FILENAME_COREDUMP;
+    for (size_t i = 0; len > 0 && i < ARRAY_SIZE(s_systemd_compressed_coredumps); ++i)
     {
-        if (dd_copy_file_unpack(dd, FILENAME_COREDUMP, coredump_path))
-            return -1;
+        const char *suffix = s_systemd_compressed_coredumps[i].suffix;
+        const size_t suffix_len = strlen(suffix);
+        if (len >= suffix_len && strcmp(coredump_path + len - suffix_len, suffix) == 0)
+        {
+            item = s_systemd_compressed_coredumps[i].item;
+            break;
+        }
     }
-    else if (len > 0)
+
+    if (len > 0)
     {
-        if (dd_copy_file(dd, FILENAME_COREDUMP, coredump_path))
-            return -1;
+        if (s_coredump_adoption != COREDUMP_ADOPTION_COPY
+            && adopt_systemd_coredump(dd, item, coredump_path) == 0)
+        {
+            log_info("Adopted '%s' as '%s'", coredump_path, item);
+        }
+        else if (strcmp(item, FILENAME_COREDUMP_ZST) == 0)
+        {
+            /* libreport cannot unpack zstd, tools decompress it when needed */
+            if (dd_copy_file(dd, item, coredump_path))
+                return -1;
+        }
+        else if (strcmp(item, FILENAME_COREDUMP) != 0)
+        {
+            if (dd_copy_file_unpack(dd, FILENAME_COREDUMP, coredump_path))
+                return -1;
+        }
+        else
+        {
+            if (dd_copy_file(dd, FILENAME_COREDUMP, coredump_path))
+                return -1;
+        }
     }
     else
     {
@@ -375,10 +557,9 @@ dump_cleanup:
 /*
  * A function called when a new journal core is detected.
  *
- * The function retrieves information from journal, checks the last occurrence
- * time of the crashed executable and if there was no recent occurrence creates
- * an ABRT problem from the journal message. Finally updates the last occurrence
- * time.
+ * The function retrieves information from journal, checks the crash rate of
+ * the crashed executable and if the rate is not exceeded creates an ABRT
+ * problem from the journal message.
  */
 static void
 abrt_journal_watch_cores(abrt_journal_watch_t *watch, void *user_data)
@@ -400,27 +581,21 @@ abrt_journal_watch_cores(abrt_journal_watch_t *watch, void *user_data)
     }
 
     // do not dump too often
-    //   ignore crashes of a single executable appearing in THROTTLE s (keep last 10 executable)
-    const unsigned current = time(NULL);
-    const unsigned last = abrt_journal_get_last_occurrence(info.ci_executable_path);
-
-    if (current < last)
+    //   ignore crashes of a single executable exceeding its crash rate
+    unsigned suppressed = 0;
+    if (throttle_table_check(conf->awc_throttle, info.ci_executable_path, time(NULL), &suppressed))
     {
-        error_msg("BUG: current time stamp lower than an old one");
-
-        if (g_verbose > 2)
-            abort();
-
+        error_msg(_("Not saving repeating crash of '%s', %u crashes throttled"),
+                info.ci_executable_path, suppressed);
+        /* Keep the count of throttled crashes across restarts. Rewriting
+         * the table is cheap compared to the core dump systemd-coredump has
+         * already written. */
+        throttle_table_save(conf->awc_throttle);
         goto watch_cleanup;
     }
 
-    const unsigned sub = current - last;
-    if (sub < conf->awc_throttle)
-    {
-        /* We don't want to update the counter here. */
-        error_msg(_("Not saving repeating crash after %ds (limit is %ds)"), sub, conf->awc_throttle);
-        goto watch_cleanup;
-    }
+    if (suppressed > 0)
+        log_warning(_("%u crashes of '%s' were throttled"), suppressed, info.ci_executable_path);
 
     if (abrt_journal_core_to_abrt_problem(&info, conf->awc_dump_location))
     {
@@ -428,11 +603,13 @@ abrt_journal_watch_cores(abrt_journal_watch_t *watch, void *user_data)
         goto watch_cleanup;
     }
 
-    abrt_journal_update_occurrence(info.ci_executable_path, current);
+    /* Creating the problem directory is much more expensive */
+    throttle_table_save(conf->awc_throttle);
 
 watch_cleanup:
-    abrt_journal_save_current_position(info.ci_journal, ABRT_JOURNAL_WATCH_STATE_FILE);
-
+    /* The position is saved by the watch in batches. Problems created after
+     * the last save are created again after a crash and abrtd detects them as
+     * duplicates. */
     if (info.ci_executable_path != NULL)
         free(info.ci_executable_path);
 
@@ -446,8 +623,11 @@ watch_journald(abrt_journal_t *journal, abrt_watch_core_conf_t *conf)
     if (abrt_journal_watch_new(&watch, journal, abrt_journal_watch_cores, (void *)conf) < 0)
         error_msg_and_die(_("Failed to initialize systemd-journal watch"));
 
+    abrt_journal_watch_save_position(watch, ABRT_JOURNAL_WATCH_STATE_FILE);
     abrt_journal_watch_run_sync(watch);
     abrt_journal_watch_free(watch);
+
+    throttle_table_save(conf->awc_throttle);
 }
 
 int
@@ -474,6 +654,7 @@ main(int argc, char *argv[])
         "the entire journal if the last seen possition is not available.\n"
         "\n"
         "The last seen position is saved in "ABRT_JOURNAL_WATCH_STATE_FILE"\n"
+        "and the crash rates of executables in "ABRT_JOURNAL_THROTTLE_STATE_FILE"\n"
     );
     enum {
         OPT_v = 1 << 0,
@@ -500,7 +681,7 @@ main(int argc, char *argv[])
         OPT_STRING('c', NULL, &cursor, "CURSOR", _("Start reading systemd-journal from the CURSOR position")),
         OPT_BOOL(  'e', NULL, NULL, _("Start reading systemd-journal from the end")),
         OPT_INTEGER('t', NULL, &throttle, _("Throttle problem directory creation to 1 per INT second")),
-        OPT_BOOL(  'T', NULL, NULL, _("Same as -t INT, INT is specified in plugins/CCpp.conf")),
+        OPT_BOOL(  'T', NULL, NULL, _("Throttle problem directory creation to CrashStormLimit per CrashStormWindow seconds specified in plugins/CCpp.conf")),
         OPT_BOOL(  'f', NULL, NULL, _("Follow systemd-journal from the last seen position (if available)")),
         OPT_END()
     };
@@ -514,6 +695,14 @@ main(int argc, char *argv[])
     if ((opts & OPT_c) && (opts & OPT_e))
         error_msg_and_die(_("You need to specify either -c CURSOR or -e"));
 
+    if ((opts & OPT_t) && (opts & OPT_T))
+        show_usage_and_die(program_usage_string, program_options);
+
+    /* -t INT is a bucket of 1 crash refilled in INT seconds */
+    unsigned throttle_burst = throttle > 0 ? 1 : 0;
+    unsigned throttle_window = throttle > 0 ? throttle : 0;
+    unsigned throttle_table_size = ABRT_JOURNAL_THROTTLE_TABLE_SIZE;
+
     /* Initialize ABRT configuration */
     load_abrt_conf();
 
@@ -542,6 +731,31 @@ main(int argc, char *argv[])
         if (value)
             g_verbose = xatoi_positive(value);
 
+        value = get_map_string_item_or_NULL(settings, "SystemdCoredumpAdoption");
+        if (value == NULL || strcmp(value, "copy") == 0)
+            s_coredump_adoption = COREDUMP_ADOPTION_COPY;
+        else if (strcmp(value, "reflink") == 0)
+            s_coredump_adoption = COREDUMP_ADOPTION_REFLINK;
+        else
+            log_warning("The SystemdCoredumpAdoption option in the CCpp.conf file holds an invalid value");
+
+        if (opts & OPT_T)
+        {
+            throttle_window = 60;
+
+            value = get_map_string_item_or_NULL(settings, "CrashStormLimit");
+            if (value && !try_get_map_string_item_as_uint(settings, "CrashStormLimit", &throttle_burst))
+                log_warning("The CrashStormLimit option in the CCpp.conf file holds an invalid value");
+
+            value = get_map_string_item_or_NULL(settings, "CrashStormWindow");
+            if (value && !try_get_map_string_item_as_uint(settings, "CrashStormWindow", &throttle_window))
+                log_warning("The CrashStormWindow option in the CCpp.conf file holds an invalid value");
+        }
+
+        value = get_map_string_item_or_NULL(settings, "CrashStormTableSize");
+        if (value && !try_get_map_string_item_as_uint(settings, "CrashStormTableSize", &throttle_table_size))
+            log_warning("The CrashStormTableSize option in the CCpp.conf file holds an invalid value");
+
         free_map_string(settings);
     }
 
@@ -581,13 +795,20 @@ main(int argc, char *argv[])
             abrt_journal_next(journal);
         }
 
+        struct throttle_table throttle_table;
+        throttle_table_init(&throttle_table, throttle_table_size, throttle_burst, throttle_window);
+        if (throttle_table_enabled(&throttle_table))
+            throttle_table_load(&throttle_table, ABRT_JOURNAL_THROTTLE_STATE_FILE);
+
         abrt_watch_core_conf_t conf = {
             .awc_dump_location = dump_location,
-            .awc_throttle = throttle,
+            .awc_throttle = &throttle_table,
         };
 
         watch_journald(journal, &conf);
 
+        throttle_table_destroy(&throttle_table);
+
         abrt_journal_save_current_position(journal, ABRT_JOURNAL_WATCH_STATE_FILE);
     }
     else
@@ -157,16 +157,18 @@ static void watch_journald(abrt_journal_t *journal, const char *dump_location, i
     struct abrt_journal_watch_notify_strings notify_strings_conf = {
         .decorated_cb = abrt_journal_watch_extract_kernel_oops,
         .decorated_cb_data = &watch_conf,
-        .strings = koops_strings,
+        .strings = strings_matcher_new(koops_strings),
     };
 
     abrt_journal_watch_t *watch = NULL;
     if (abrt_journal_watch_new(&watch, journal, abrt_journal_watch_notify_strings, &notify_strings_conf) < 0)
         error_msg_and_die(_("Failed to initialize systemd-journal watch"));
 
+    abrt_journal_watch_save_position(watch, ABRT_JOURNAL_WATCH_STATE_FILE);
     abrt_journal_watch_run_sync(watch);
     abrt_journal_watch_free(watch);
 
+    strings_matcher_free(notify_strings_conf.strings);
     g_list_free(koops_strings);
 }
 
@@ -23,8 +23,18 @@
 #define MAX_SCAN_BLOCK  (4*1024*1024)
 #define READ_AHEAD          (10*1024)
 #define ABRT_DUMP_OOPS_ANALYZER "abrt-oops"
+/* An unfinished oops at the end of the log is recorded when no more lines
+ * were appended to it for this number of seconds */
+#define PENDING_OOPS_TIMEOUT 60
 
-static void scan_syslog_file(GList **oops_list, int fd)
+/* Scans the file in blocks of constant size. Lines of an oops which might
+ * continue in the next block are moved to the beginning of the block and
+ * scanned again together with the following data.
+ *
+ * If keep_tail is true, the lines of an oops which has not ended at the end of
+ * the file are left for the next run. Returns the number of processed bytes.
+ */
+static off_t scan_syslog_file(GList **oops_list, int fd, bool keep_tail)
 {
     struct stat st;
     struct stat *statbuf = &st;
@@ -48,17 +58,174 @@ static void scan_syslog_file(GList **oops_list, int fd)
     sz += READ_AHEAD;
     char *buffer = xzalloc(sz);
 
+    off_t processed = 0;
+    size_t len = 0;
     for (;;)
     {
-        int r = full_read(fd, buffer, sz-1);
+        int r = full_read(fd, buffer + len, sz - 1 - len);
         if (r <= 0)
             break;
         log_debug("Read %u bytes", r);
-        koops_extract_oopses(oops_list, buffer, r);
-//TODO: rewind to last newline?
+        len += r;
+
+        size_t done = koops_extract_oopses_from_chunk(oops_list, buffer, len, /*last chunk*/false);
+        if (done == 0 && len == (size_t)sz - 1)
+        {
+            /* Not a single oops fits into the block, scan it as it is */
+            log_notice("Lines at offset %lld do not fit into the scan block", (long long)processed);
+            koops_extract_oopses(oops_list, buffer, len);
+            done = len;
+        }
+
+        len -= done;
+        memmove(buffer, buffer + done, len);
+        processed += done;
+    }
+
+    if (len > 0 && keep_tail)
+    {
+        /* There are no more lines now, record the oopses which have ended */
+        processed += koops_extract_oopses_from_chunk(oops_list, buffer, len, /*last chunk*/true);
+    }
+    else if (len > 0)
+    {
+        koops_extract_oopses(oops_list, buffer, len);
+        processed += len;
     }
 
     free(buffer);
+    return processed;
+}
+
+/* The resume file holds the device, the inode and the offset of the scanned
+ * part of the file, the time since when the rest of the file holds an
+ * unfinished oops (0 if it does not) and the size of the file at that time.
+ */
+struct resume_point
+{
+    unsigned long long dev;
+    unsigned long long ino;
+    long long offset;
+    long long pending_since;
+    long long end;
+};
+
+static bool load_resume_point(const char *resume_file, struct resume_point *rp)
+{
+    FILE *fp = fopen(resume_file, "r");
+    if (fp == NULL)
+    {
+        if (errno != ENOENT)
+            perror_msg("Can't open '%s'", resume_file);
+        return false;
+    }
+
+    rp->pending_since = 0;
+    rp->end = 0;
+    const int r = fscanf(fp, "%llu %llu %lld %lld %lld", &rp->dev, &rp->ino, &rp->offset,
+                         &rp->pending_since, &rp->end);
+    fclose(fp);
+
+    /* Files written by older versions do not have the time and the size */
+    if (r < 3 || rp->offset < 0)
+    {
+        error_msg("Malformed resume file '%s'", resume_file);
+        return false;
+    }
+
+    return true;
+}
+
+static void save_resume_point(const char *resume_file, int fd, off_t offset, time_t pending_since,
+                off_t end)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        perror_msg("Can't stat the log file");
+        return;
+    }
+
+    char *tmp_file = xasprintf("%s.new", resume_file);
+    FILE *fp = fopen(tmp_file, "w");
+    if (fp == NULL)
+    {
+        perror_msg("Can't open '%s'", tmp_file);
+        goto cleanup;
+    }
+
+    fprintf(fp, "%llu %llu %lld %lld %lld\n", (unsigned long long)st.st_dev,
+            (unsigned long long)st.st_ino, (long long)offset, (long long)pending_since,
+            (long long)end);
+
+    if (fclose(fp) != 0)
+    {
+        perror_msg("Can't write '%s'", tmp_file);
+        goto cleanup;
+    }
+
+    if (rename(tmp_file, resume_file) != 0)
+        perror_msg("Can't rename '%s' to '%s'", tmp_file, resume_file);
+
+cleanup:
+    unlink(tmp_file);
+    free(tmp_file);
+}
+
+/* Looks up the rotated log file by its device and inode in the directory of
+ * the current log file. Returns its descriptor or -1.
+ */
+static int open_rotated_log(const char *log_file, const struct resume_point *rp)
+{
+    gchar *dir_name = g_path_get_dirname(log_file);
+    DIR *dir = opendir(dir_name);
+    if (dir == NULL)
+    {
+        perror_msg("Can't open directory '%s'", dir_name);
+        g_free(dir_name);
+        return -1;
+    }
+    g_free(dir_name);
+
+    int fd = -1;
+    struct dirent *dent;
+    while ((dent = readdir(dir)) != NULL)
+    {
+        struct stat st;
+        if (fstatat(dirfd(dir), dent->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0
+         && S_ISREG(st.st_mode)
+         && st.st_dev == rp->dev
+         && st.st_ino == rp->ino)
+        {
+            fd = openat(dirfd(dir), dent->d_name, O_RDONLY | O_NOCTTY);
+            break;
+        }
+    }
+
+    closedir(dir);
+    return fd;
+}
+
+/* Scans the rest of the log file which was rotated after the last run, so
+ * the lines which were left for the next run are not lost. */
+static void scan_rotated_log(GList **oops_list, const char *log_file, const struct resume_point *rp)
+{
+    const int fd = open_rotated_log(log_file, rp);
+    if (fd < 0)
+    {
+        log_notice("The rotated log file was not found");
+        return;
+    }
+
+    if (lseek(fd, rp->offset, SEEK_SET) < 0)
+        perror_msg("Can't seek to %lld", rp->offset);
+    else
+    {
+        log_debug("Scanning the rotated log file at offset %lld", rp->offset);
+        scan_syslog_file(oops_list, fd, /*keep tail*/false);
+    }
+
+    close(fd);
 }
 
 int main(int argc, char **argv)
@@ -74,7 +241,7 @@ int main(int argc, char **argv)
 
     /* Can't keep these strings/structs static: _() doesn't support that */
     const char *program_usage_string = _(
-        "& [-vusoxm] [-d DIR]/[-D] [FILE]\n"
+        "& [-vusoxm] [-d DIR]/[-D] [-r RESUME_FILE] [FILE]\n"
         "\n"
         "Extract oops from FILE (or standard input)"
     );
@@ -88,9 +255,11 @@ int main(int argc, char **argv)
         OPT_x = 1 << 6,
         OPT_t = 1 << 7,
         OPT_m = 1 << 8,
+        OPT_r = 1 << 9,
     };
     char *problem_dir = NULL;
     char *dump_location = NULL;
+    char *resume_file = NULL;
     /* Keep enum above and order of options below in sync! */
     struct options program_options[] = {
         OPT__VERBOSE(&g_verbose),
@@ -105,6 +274,7 @@ int main(int argc, char **argv)
         OPT_BOOL(  'x', NULL, NULL, _("Make the problem directory world readable")),
         OPT_BOOL(  't', NULL, NULL, _("Throttle problem directory creation to 1 per second")),
         OPT_BOOL(  'm', NULL, NULL, _("Print search string(s) to stdout and exit")),
+        OPT_STRING('r', NULL, &resume_file, "RESUME_FILE", _("Continue scanning FILE at the offset saved in RESUME_FILE and save the reached offset there")),
         OPT_END()
     };
     unsigned opts = parse_opts(argc, argv, program_options, program_usage_string);
@@ -164,7 +334,51 @@ int main(int argc, char **argv)
         xmove_fd(xopen(argv[0], O_RDONLY), STDIN_FILENO);
 
     GList *oops_list = NULL;
-    scan_syslog_file(&oops_list, STDIN_FILENO);
+    off_t offset = 0;
+    time_t pending_since = 0;
+    const time_t now = time(NULL);
+    if (opts & OPT_r)
+    {
+        struct stat st;
+        if (fstat(STDIN_FILENO, &st) != 0 || !S_ISREG(st.st_mode))
+            error_msg_and_die(_("Resuming requires a regular file"));
+
+        struct resume_point rp;
+        if (!load_resume_point(resume_file, &rp))
+            /* Scan the whole file */;
+        else if (rp.dev == st.st_dev && rp.ino == st.st_ino && rp.offset <= st.st_size)
+        {
+            offset = rp.offset;
+            pending_since = rp.pending_since;
+
+            /* Lines appended to an unfinished oops restart its timeout */
+            if (pending_since != 0 && st.st_size > rp.end)
+                pending_since = now;
+        }
+        else
+        {
+            log_notice("The log file was rotated, scanning it from the beginning");
+            if (argv[0] && (rp.dev != st.st_dev || rp.ino != st.st_ino))
+                scan_rotated_log(&oops_list, argv[0], &rp);
+        }
+
+        if (lseek(STDIN_FILENO, offset, SEEK_SET) < 0)
+            perror_msg_and_die("Can't seek to %lld", (long long)offset);
+        log_debug("Resuming at offset %lld", (long long)offset);
+    }
+
+    /* Do not wait for the rest of an unfinished oops forever */
+    const bool keep_tail = (opts & OPT_r)
+                        && (pending_since == 0 || now - pending_since < PENDING_OOPS_TIMEOUT);
+    const off_t scanned = scan_syslog_file(&oops_list, STDIN_FILENO, keep_tail);
+    const off_t end = keep_tail ? lseek(STDIN_FILENO, 0, SEEK_CUR) : 0;
+
+    if (!keep_tail || end < 0 || offset + scanned >= end)
+        pending_since = 0;
+    else if (scanned != 0 || pending_since == 0)
+        /* A new unfinished oops was left for the next run */
+        pending_since = now;
+    offset += scanned;
 
     unsigned errors = 0;
     if (opts & OPT_u)
@@ -201,5 +415,9 @@ int main(int argc, char **argv)
     list_free_with_free(oops_list);
     //oops_list = NULL;
 
+    /* The found oopses were processed, don't find them again */
+    if (opts & OPT_r)
+        save_resume_point(resume_file, STDIN_FILENO, offset, pending_since, end);
+
     return errors;
 }
@@ -17,6 +17,7 @@
 #include <poll.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
 
 #include "abrt-journal.h"
 #include "libabrt.h"
@@ -375,6 +376,16 @@ struct abrt_journal_watch
 
     abrt_journal_watch_callback callback;
     void *callback_data;
+
+    /* Batched saving of the position, see abrt_journal_watch_save_position() */
+    const char *state_file;
+    unsigned unsaved_entries;
+    time_t last_save;
+
+    /* Statistics logged when the loop ends */
+    unsigned long long entries;
+    unsigned saves;
+    double busy_seconds;
 };
 
 int abrt_journal_watch_new(abrt_journal_watch_t **watch, abrt_journal_t *journal, abrt_journal_watch_callback callback, void *callback_data)
@@ -400,6 +411,38 @@ abrt_journal_t *abrt_journal_watch_get_journal(abrt_journal_watch_t *watch)
     return watch->j;
 }
 
+void abrt_journal_watch_save_position(abrt_journal_watch_t *watch, const char *state_file)
+{
+    watch->state_file = state_file;
+    watch->last_save = time(NULL);
+}
+
+/* Saves the position if there are unsaved entries and either force is true
+ * or the limits were reached. */
+static void abrt_journal_watch_checkpoint(abrt_journal_watch_t *watch, bool force)
+{
+    if (watch->state_file == NULL || watch->unsaved_entries == 0)
+        return;
+
+    const time_t now = time(NULL);
+    if (!force
+     && watch->unsaved_entries < ABRT_JOURNAL_WATCH_SAVE_ENTRIES
+     && now - watch->last_save < ABRT_JOURNAL_WATCH_SAVE_INTERVAL)
+        return;
+
+    abrt_journal_save_current_position(watch->j, watch->state_file);
+    watch->unsaved_entries = 0;
+    watch->last_save = now;
+    ++watch->saves;
+}
+
+static double monotonic_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
 int abrt_journal_watch_run_sync(abrt_journal_watch_t *watch)
 {
     sigset_t mask;
@@ -423,6 +466,7 @@ int abrt_journal_watch_run_sync(abrt_journal_watch_t *watch)
     pollfd.events = sd_journal_get_events(watch->j->j);
 
     int r = 0;
+    double busy_since = monotonic_seconds();
 
     while (!s_loop_terminated && watch->state == ABRT_JOURNAL_WATCH_READY)
     {
@@ -434,7 +478,13 @@ int abrt_journal_watch_run_sync(abrt_journal_watch_t *watch)
         }
         else if (r == 0)
         {
+            /* All entries were processed, don't wait with unsaved position */
+            abrt_journal_watch_checkpoint(watch, /*force*/true);
+
+            watch->busy_seconds += monotonic_seconds() - busy_since;
             ppoll(&pollfd, 1, NULL, &mask);
+            busy_since = monotonic_seconds();
+
             r = sd_journal_process(watch->j->j);
             if (r < 0)
             {
@@ -445,8 +495,21 @@ int abrt_journal_watch_run_sync(abrt_journal_watch_t *watch)
         }
 
         watch->callback(watch, watch->callback_data);
+
+        ++watch->entries;
+        ++watch->unsaved_entries;
+        abrt_journal_watch_checkpoint(watch, /*force*/false);
     }
 
+    /* Terminated by a signal or stopped */
+    abrt_journal_watch_checkpoint(watch, /*force*/true);
+
+    watch->busy_seconds += monotonic_seconds() - busy_since;
+    log_notice("Processed %llu journal entries in %.3fs (%.0f entries/s), the position was saved %u times",
+            watch->entries, watch->busy_seconds,
+            watch->busy_seconds > 0 ? watch->entries / watch->busy_seconds : 0.0,
+            watch->saves);
+
     return r;
 }
 
@@ -468,16 +531,7 @@ void abrt_journal_watch_notify_strings(abrt_journal_watch_t *watch, void *data)
     if (abrt_journal_get_string_field(abrt_journal_watch_get_journal(watch), "MESSAGE", (char *)message) == NULL)
         error_msg_and_die("Cannot read journal data.");
 
-    GList *cur = conf->strings;
-    while (cur)
-    {
-        if (strstr(message, cur->data) != NULL)
-            break;
-
-        cur = g_list_next(cur);
-    }
-
-    if (cur)
+    if (strings_matcher_find(conf->strings, message) != NULL)
         conf->decorated_cb(watch, conf->decorated_cb_data);
 }
 
@@ -106,6 +106,18 @@ void abrt_journal_watch_free(abrt_journal_watch_t *watch);
  */
 abrt_journal_t *abrt_journal_watch_get_journal(abrt_journal_watch_t *watch);
 
+/*
+ * Saves the position of the watched journal to the state file after
+ * ABRT_JOURNAL_WATCH_SAVE_ENTRIES entries or ABRT_JOURNAL_WATCH_SAVE_INTERVAL
+ * seconds, before waiting for new messages and when the loop ends. Entries
+ * processed after the last save are processed again after a crash.
+ */
+#define ABRT_JOURNAL_WATCH_SAVE_ENTRIES 256
+#define ABRT_JOURNAL_WATCH_SAVE_INTERVAL 5
+
+void abrt_journal_watch_save_position(abrt_journal_watch_t *watch,
+                                      const char *state_file);
+
 /*
  * Starts reading journal messages and waiting for new messages in a loop.
  *
@@ -124,11 +136,14 @@ void abrt_journal_watch_stop(abrt_journal_watch_t *watch);
  * back in case where journal message contains a string from the interested
  * list.
  */
+struct strings_matcher;
+
 struct abrt_journal_watch_notify_strings
 {
     abrt_journal_watch_callback decorated_cb;
     void *decorated_cb_data;
-    GList *strings;
+    /* The interested strings compiled by strings_matcher_new() */
+    struct strings_matcher *strings;
 };
 
 void abrt_journal_watch_notify_strings(abrt_journal_watch_t *watch, void *data);
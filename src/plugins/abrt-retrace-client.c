@@ -43,6 +43,8 @@ struct retrace_settings
 
 static const char *dump_dir_name = NULL;
 static const char *coredump = NULL;
+/* The value returned by unpack_compressed_coredump() */
+static int unpacked_coredump = 0;
 static const char *required_retrace[] = { FILENAME_COREDUMP,
                                           FILENAME_EXECUTABLE,
                                           FILENAME_PACKAGE,
@@ -435,6 +437,11 @@ static int check_package(const char *nvr, const char *arch, map_string_t *osinfo
     return response_code == 302;
 }
 
+static void remove_unpacked_coredump_at_exit(void)
+{
+    remove_unpacked_coredump(dump_dir_name, unpacked_coredump);
+}
+
 static int create(bool delete_temp_archive,
                   char **task_id,
                   char **task_password)
@@ -471,6 +478,13 @@ static int create(bool delete_temp_archive,
             task_type = TASK_VMCORE;
         dd_close(dd);
 
+        /* Retrace server expects the raw core dump */
+        if (task_type != TASK_VMCORE)
+        {
+            unpacked_coredump = unpack_compressed_coredump(dump_dir_name);
+            atexit(remove_unpacked_coredump_at_exit);
+        }
+
         char *path;
         int i = 0;
         const char **required_files = task_type == TASK_VMCORE ? required_vmcore : required_retrace;
@@ -611,6 +625,11 @@ static int create(bool delete_temp_archive,
     }
 
     int tempfd = create_archive(delete_temp_archive);
+
+    /* The archive contains its own copy of the core dump */
+    remove_unpacked_coredump(dump_dir_name, unpacked_coredump);
+    unpacked_coredump = 0;
+
     if (-1 == tempfd)
         return 1;
 
@@ -30,8 +30,24 @@
 
 TEST="abrt-dump-journal-core"
 PACKAGE="abrt"
+CCPP_CONF=/etc/abrt/plugins/CCpp.conf
+THROTTLE_FILE=/var/lib/abrt/abrt-dump-journal-core.throttle
 CORE_REQUIRED_FILES="abrt_version analyzer architecture cmdline component core_backtrace count dso_list environ executable hostname kernel last_occurrence limits maps open_fds os_info os_release package pid pkg_arch pkg_epoch pkg_name pkg_release pkg_version reason time type uid username"
 
+# Prints the number of throttled crashes of the executable saved in the
+# throttle table or nothing if the executable is not in the table
+function throttled_crashes() {
+    awk -v e="$1" '$4 == e { print $3 }' $THROTTLE_FILE 2>/dev/null
+}
+
+# Waits until the throttle table holds the expected count for the executable
+function wait_for_throttled_crashes() {
+    for i in $(seq 30); do
+        [ "$(throttled_crashes $1)" == "$2" ] && return
+        sleep 1
+    done
+}
+
 rlJournalStart
     rlPhaseStartSetup
         check_prior_crashes
@@ -83,6 +99,83 @@ rlJournalStart
         rlRun "abrt-cli remove $crash_PATH"
     rlPhaseEnd
 
+    rlPhaseStartTest "batched saving of the journal position"
+        rlRun "systemctl stop abrt-journal-core.service"
+
+        STATE_FILE=/var/lib/abrt/abrt-dump-journal-core.state
+        FLOOD_ID="abrt-journal-flood-$$"
+        FLOOD_ENTRIES=20000
+
+        ABRT_DUMP_JOURNAL_CORE_DEBUG_FILTER="SYSLOG_IDENTIFIER=$FLOOD_ID" \
+            abrt-dump-journal-core -vvv -e -f -d $TmpDir/dumps > flood.log 2>&1 &
+        watcher_pid=$!
+        sleep 2
+
+        rlRun "seq $FLOOD_ENTRIES | systemd-cat -t $FLOOD_ID"
+        rlRun "journalctl --flush"
+
+        # The position must be saved once all entries are processed
+        last_cursor=$(journalctl -q -n 1 -o export SYSLOG_IDENTIFIER=$FLOOD_ID | sed -n 's/^__CURSOR=//p')
+        for i in $(seq 60); do
+            [ "$(cat $STATE_FILE)" == "$last_cursor" ] && break
+            sleep 1
+        done
+        rlAssertEquals "The last processed entry is saved" "$(cat $STATE_FILE)" "$last_cursor"
+
+        rlRun "kill -TERM $watcher_pid"
+        rlRun "wait $watcher_pid"
+
+        rlAssertGrep "Processed $FLOOD_ENTRIES journal entries" flood.log
+        rlLog "$(grep 'journal entries' flood.log)"
+
+        saves=$(sed -n 's/.*the position was saved \([0-9]*\) times.*/\1/p' flood.log)
+        rlAssertGreater "The position was saved in batches" $FLOOD_ENTRIES $saves
+
+        rlRun "systemctl start abrt-journal-core.service"
+    rlPhaseEnd
+
+    rlPhaseStartTest "throttling of repeating crashes"
+        rlRun "systemctl stop abrt-journal-core.service"
+        rlFileBackup $CCPP_CONF
+        rlFileBackup --missing-ok $THROTTLE_FILE
+        rlRun "rm -f $THROTTLE_FILE"
+        rlRun "augtool set /files${CCPP_CONF}/CrashStormLimit 1"
+        rlRun "augtool set /files${CCPP_CONF}/CrashStormWindow 3600"
+        rlRun "augtool set /files${CCPP_CONF}/CrashStormTableSize 2"
+        rlRun "systemctl start abrt-journal-core.service"
+        sleep 2
+
+        generate_crash
+        wait_for_throttled_crashes /usr/bin/will_segfault 0
+        rlAssertEquals "The first crash is not throttled" "$(throttled_crashes /usr/bin/will_segfault)" "0"
+
+        generate_crash
+        wait_for_throttled_crashes /usr/bin/will_segfault 1
+        rlAssertEquals "The throttled crash is saved in the table" "$(throttled_crashes /usr/bin/will_segfault)" "1"
+
+        # The table survives restarts
+        rlRun "systemctl restart abrt-journal-core.service"
+        sleep 2
+        generate_crash
+        wait_for_throttled_crashes /usr/bin/will_segfault 2
+        rlAssertEquals "The crash is throttled after restart" "$(throttled_crashes /usr/bin/will_segfault)" "2"
+
+        # The least recently crashed executable is forgotten
+        generate_second_crash
+        wait_for_throttled_crashes /usr/bin/will_abort 0
+        generate_stack_overflow_crash
+        wait_for_throttled_crashes /usr/bin/will_stackoverflow 0
+        rlAssertEquals "The table is limited to 2 executables" "$(wc -l < $THROTTLE_FILE)" "2"
+        rlAssertNotGrep "/usr/bin/will_segfault" $THROTTLE_FILE
+
+        rlRun "systemctl stop abrt-journal-core.service"
+        for crash in $(abrt-cli list 2>/dev/null | sed -n 's/^Directory:\s*//p'); do
+            abrt-cli remove $crash > /dev/null
+        done
+        rlFileRestore
+        rlRun "systemctl start abrt-journal-core.service"
+    rlPhaseEnd
+
     rlPhaseStartCleanup
         rlRun "systemctl stop abrt-journal-core.service"
         rlRun "systemctl start abrt-ccpp.service"
@@ -0,0 +1,53 @@
+#!/usr/bin/python3
+# Talks to abrtd's socket:
+#   pool_client.py bad COUNT  - sends COUNT bad requests one by one and fails
+#                               if any of them is not answered
+#   pool_client.py cut        - sends a part of a problem and disconnects
+#   pool_client.py problem TAG - sends a complete problem and fails if it is
+#                               not accepted
+
+import os
+import socket
+import sys
+
+SOCKET_PATH = "/var/run/abrt/abrt.socket"
+
+
+def connect():
+    s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    s.connect(SOCKET_PATH)
+    return s
+
+
+def request(data, expected):
+    s = connect()
+    s.sendall(data)
+    s.shutdown(socket.SHUT_WR)
+    response = s.recv(64)
+    s.close()
+    if not response.startswith(expected):
+        sys.stderr.write("Unexpected response: %s\n" % response)
+        sys.exit(1)
+
+
+mode = sys.argv[1]
+if mode == "bad":
+    for i in range(int(sys.argv[2])):
+        request(b"GET / HTTP/1.1\r\n\r\n", b"HTTP/1.1 400")
+elif mode == "cut":
+    s = connect()
+    s.sendall(b"POST / HTTP/1.1\r\n\r\ntype=abrt-server-pool\0reason=")
+    s.close()
+elif mode == "problem":
+    items = [b"type=abrt-server-pool",
+             b"analyzer=abrt-server-pool",
+             b"reason=abrt-server pool test",
+             b"pid=%d" % os.getpid(),
+             ("basename=%s" % sys.argv[2]).encode(),
+             ("executable=/usr/bin/%s" % sys.argv[2]).encode(),
+             b"backtrace=die()"]
+    request(b"POST / HTTP/1.1\r\n\r\n" + b"".join(i + b"\0" for i in items),
+            b"HTTP/1.1 201")
+else:
+    sys.stderr.write("Unknown mode: %s\n" % mode)
+    sys.exit(2)
@@ -0,0 +1,115 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of abrt-server-pool
+#   Description: Checks that resident abrt-server processes serve many clients, are replaced after their last client and survive clients disconnecting in the middle of a request
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2016 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="abrt-server-pool"
+PACKAGE="abrt"
+
+# abrtd keeps ABRT_SERVER_POOL_SIZE resident abrt-server processes and
+# a resident process exits after WORKER_MAX_CLIENTS clients
+POOL_SIZE=4
+WORKER_MAX_CLIENTS=256
+
+# Prints sorted PIDs of the resident abrt-server processes
+function resident_servers
+{
+    pgrep -P $(pidof abrtd) -f '^abrt-server( -s)? -w$' | sort
+}
+
+# Waits until abrtd has the full pool of resident abrt-server processes
+function wait_for_pool
+{
+    for i in $(seq 50); do
+        [ $(resident_servers | wc -l) -eq $POOL_SIZE ] && return
+        sleep 0.1
+    done
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        check_prior_crashes
+        load_abrt_conf
+
+        TmpDir=$(mktemp -d)
+        cp pool_client.py $TmpDir
+        pushd $TmpDir
+
+        rlRun "systemctl restart abrtd"
+        sleep 1
+        wait_for_pool
+        rlAssertEquals "abrtd started the pool" "$(resident_servers | wc -l)" "$POOL_SIZE"
+    rlPhaseEnd
+
+    rlPhaseStartTest "resident processes are reused"
+        resident_servers > servers.before
+        rlRun "./pool_client.py bad 20" 0 "Every client is answered"
+        resident_servers > servers.after
+        rlAssertNotDiffer servers.before servers.after
+        rlAssertEquals "No abrt-server was started for the clients" \
+            "$(pgrep -P $(pidof abrtd) -x abrt-server | wc -l)" "$POOL_SIZE"
+    rlPhaseEnd
+
+    rlPhaseStartTest "retiring processes are replaced"
+        resident_servers > servers.before
+        # Every resident process serves more than its last client
+        rlRun "./pool_client.py bad $(( POOL_SIZE * WORKER_MAX_CLIENTS + POOL_SIZE ))" 0 \
+            "No client is lost when a resident process retires"
+        wait_for_pool
+        resident_servers > servers.after
+        rlAssertEquals "The pool is refilled" "$(wc -l < servers.after)" "$POOL_SIZE"
+        rlAssertEquals "The retired processes were replaced" \
+            "$(comm -12 servers.before servers.after | wc -l)" "0"
+    rlPhaseEnd
+
+    rlPhaseStartTest "client disconnecting in the middle of a request"
+        for i in $(seq $(( POOL_SIZE * 2 ))); do
+            rlRun "./pool_client.py cut"
+        done
+        wait_for_pool
+        rlAssertEquals "The pool is refilled" "$(resident_servers | wc -l)" "$POOL_SIZE"
+        rlAssertEquals "No staging directory is left behind" \
+            "$(ls -d $ABRT_CONF_DUMP_LOCATION/abrt-server-*.new 2>/dev/null | wc -l)" "0"
+
+        rlRun "./pool_client.py problem abrt-server-pool-$$" 0 "The next client is served"
+        # Wait until post-create finishes
+        sleep 2
+        rlAssertEquals "The problem was saved" \
+            "$(ls -d $ABRT_CONF_DUMP_LOCATION/abrt-server-pool-$$* 2>/dev/null | wc -l)" "1"
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        for crash in $ABRT_CONF_DUMP_LOCATION/abrt-server-pool*; do
+            test -d "$crash" && abrt-cli remove "$crash" > /dev/null
+        done
+        popd # TmpDir
+        rm -rf $TmpDir
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
@@ -0,0 +1,101 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of abrt-server-throughput
+#   Description: Measures throughput of abrt-server and checks its memory does not grow with size of problem data
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2016 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="abrt-server-throughput"
+PACKAGE="abrt"
+ABRT_CONF=/etc/abrt/abrt.conf
+AASPD_CONF=/etc/abrt/abrt-action-save-package-data.conf
+
+bench_param BENCH_ITERATIONS 50
+# Sizes of the sent backtraces in bytes
+bench_param BENCH_BACKTRACE_SIZES "4096 1048576 3145728"
+# Allowed growth of peak memory of abrt-server between the smallest and the
+# largest backtrace
+bench_param BENCH_MAX_HWM_GROWTH_KiB 1024
+
+# Prints the largest peak resident set size of running abrt-server processes
+function abrt_server_hwm
+{
+    local hwm=0
+    for pid in $(pgrep -x abrt-server); do
+        local v=$(sed -n 's/^VmHWM:\s*\([0-9]*\) kB/\1/p' /proc/$pid/status)
+        test -n "$v" && test $v -gt $hwm && hwm=$v
+    done
+    echo $hwm
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        bench_log_params
+        check_prior_crashes
+        load_abrt_conf
+
+        TmpDir=$(mktemp -d)
+        cp send_problems.py $TmpDir
+        pushd $TmpDir
+
+        rlFileBackup $ABRT_CONF $AASPD_CONF
+        rlRun "augtool set /files${ABRT_CONF}/MaxCrashReportsSize 0"
+        # The sent problems have made-up executables which no package owns
+        rlRun "augtool set /files${AASPD_CONF}/ProcessUnpackaged yes"
+        rlRun "systemctl restart abrtd"
+        sleep 1
+    rlPhaseEnd
+
+    HWM_FIRST=
+    for size in $BENCH_BACKTRACE_SIZES; do
+        rlPhaseStartTest "${size} bytes backtrace"
+            rlRun "MBPS=\$(./send_problems.py $BENCH_ITERATIONS $size bench-$size)"
+            # Wait until all abrt-server processes finish post-create
+            sleep 2
+            HWM=$(abrt_server_hwm)
+            test -z "$HWM_FIRST" && HWM_FIRST=$HWM
+
+            rlLog "backtrace=${size}B iterations=$BENCH_ITERATIONS throughput=${MBPS}MB/s abrt-server VmHWM=${HWM}kB"
+            rlAssertGreater "abrt-server peak memory does not grow with the backtrace" \
+                $(( HWM_FIRST + BENCH_MAX_HWM_GROWTH_KiB )) $HWM
+
+            rlAssertEquals "All problems were saved" "$(ls -d $ABRT_CONF_DUMP_LOCATION/bench-$size-* | wc -l)" "$BENCH_ITERATIONS"
+            for crash in $ABRT_CONF_DUMP_LOCATION/bench-$size-*; do
+                test -d "$crash" && abrt-cli remove "$crash" > /dev/null
+            done
+        rlPhaseEnd
+    done
+
+    rlPhaseStartCleanup
+        rlAssertEquals "No staging directory is left behind" "$(ls -d $ABRT_CONF_DUMP_LOCATION/abrt-server-*.new 2>/dev/null | wc -l)" "0"
+        rlFileRestore
+        rlRun "systemctl restart abrtd"
+        popd # TmpDir
+        rm -rf $TmpDir
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
@@ -0,0 +1,53 @@
+#!/usr/bin/python3
+# Sends COUNT problems with a backtrace of SIZE bytes to abrtd's socket and
+# prints the number of sent bytes per second.
+
+import os
+import socket
+import sys
+import time
+
+SOCKET_PATH = "/var/run/abrt/abrt.socket"
+CHUNK_SIZE = 64 * 1024
+
+count = int(sys.argv[1])
+size = int(sys.argv[2])
+tag = sys.argv[3]
+
+line = b"#1 0x0000000000400abc in benchmark_frame () at benchmark.c:42\n"
+backtrace = (line * (size // len(line) + 1))[:size]
+
+sent = 0
+start = time.monotonic()
+for i in range(count):
+    items = [b"type=abrt-server-throughput",
+             b"analyzer=abrt-server-throughput",
+             b"reason=abrt-server throughput benchmark",
+             b"pid=%d" % os.getpid(),
+             # problem directories created in the same second need unique names
+             ("basename=%s-%d" % (tag, i)).encode(),
+             # abrt-server ignores repeated problems of the same executable
+             ("executable=/usr/bin/%s-%d" % (tag, i)).encode()]
+
+    s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    s.connect(SOCKET_PATH)
+    s.sendall(b"POST / HTTP/1.1\r\n\r\n")
+    for item in items:
+        s.sendall(item + b"\0")
+        sent += len(item) + 1
+
+    s.sendall(b"backtrace=")
+    for ofs in range(0, len(backtrace), CHUNK_SIZE):
+        s.sendall(backtrace[ofs:ofs + CHUNK_SIZE])
+    s.sendall(b"\0")
+    sent += len(backtrace) + len(b"backtrace=") + 1
+
+    s.shutdown(socket.SHUT_WR)
+    response = s.recv(64)
+    s.close()
+    if not response.startswith(b"HTTP/1.1 201"):
+        sys.stderr.write("Unexpected response: %s\n" % response)
+        sys.exit(1)
+
+elapsed = time.monotonic() - start
+print("%.1f" % (sent / elapsed / 1000000))
@@ -172,3 +172,23 @@ function wait_for_server() {
         sleep 0.01
     done
 }
+
+# Benchmarks can be tuned from the environment. Sets the variable $1 to the
+# default value $2 unless it is set already.
+function bench_param() {
+    local name=$1
+    test -n "${!name}" || printf -v "$name" '%s' "$2"
+}
+
+# Logs the values of all benchmark parameters
+function bench_log_params() {
+    local name
+    for name in ${!BENCH_@}; do
+        rlLog "$name=${!name}"
+    done
+}
+
+# Prints the current time in microseconds
+function bench_now_us() {
+    echo $(( $(date +%s%N) / 1000 ))
+}
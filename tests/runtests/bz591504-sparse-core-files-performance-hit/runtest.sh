@@ -46,27 +46,55 @@ rlJournalStart
         sed -i 's/\(MakeCompatCore\) = no/\1 = yes/g' $CCPP_CFG_FILE
     rlPhaseEnd
 
-    rlPhaseStartTest
-        # Making sure abrt is intercepting coredumps
-        # (otherwise test will "pass" but we'd not test abrt, just the kernel)
-        rlAssertGrep "abrt-hook-ccpp" /proc/sys/kernel/core_pattern
+    # Crashes bigcore, waits for the hook and reports throughput of the hook
+    # in MiB/s of the apparent core size.
+    function bigcore_benchmark() {
+        local mode=$1
+
+        rlRun "rm -f core* /tmp/abrt-done"
+        local start=$(date +%s.%N)
+        rlRun "sh -c './bigcore; exit 0' &>/dev/null"
+        wait_for_hooks
+        local end=$(date +%s.%N)
 
-        rlLog "Generating core"
-        rlRun "rm core* 2>/dev/null; sh -c './bigcore; exit 0' &>/dev/null"
         rlAssertExists core*
         apparent_coresize=$(du -B1 --apparent-size core* | sed 's/[ \t].*//')
         actual_coresize=$(du -B1 core* | sed 's/[ \t].*//')
-        rlLog "Core sizes: apparent:$apparent_coresize actual:$actual_coresize"
+        rlLog "$mode: Core sizes: apparent:$apparent_coresize actual:$actual_coresize"
 
         # In my experience here apparent size is almost 500 times bigger
-        rlAssertGreater "Corefile is very sparse" $((apparent_coresize/50)) $actual_coresize
-    rlPhaseEnd
+        rlAssertGreater "$mode: Corefile is very sparse" $((apparent_coresize/50)) $actual_coresize
 
-    rlPhaseStartCleanup
-        wait_for_hooks
         get_crash_path
+        abrt_apparent_coresize=$(du -B1 --apparent-size $crash_PATH/coredump | sed 's/[ \t].*//')
+        abrt_actual_coresize=$(du -B1 $crash_PATH/coredump | sed 's/[ \t].*//')
+        rlLog "$mode: ABRT core sizes: apparent:$abrt_apparent_coresize actual:$abrt_actual_coresize"
+
+        local seconds=$(echo "$end - $start" | bc)
+        local throughput=$(echo "scale=2; $apparent_coresize / 1048576 / $seconds" | bc)
+        rlLog "$mode: Captured in $seconds seconds ($throughput MiB/s)"
+
         rlRun "abrt-cli rm $crash_PATH" 0 "Remove crash directory"
+    }
 
+    rlPhaseStartTest "SparseCore = no"
+        # Making sure abrt is intercepting coredumps
+        # (otherwise test will "pass" but we'd not test abrt, just the kernel)
+        rlAssertGrep "abrt-hook-ccpp" /proc/sys/kernel/core_pattern
+
+        rlLog "Generating core"
+        bigcore_benchmark "dense"
+    rlPhaseEnd
+
+    rlPhaseStartTest "SparseCore = yes"
+        echo "SparseCore = yes" >> $CCPP_CFG_FILE
+
+        rlLog "Generating core"
+        bigcore_benchmark "sparse"
+        rlAssertGreater "ABRT core is very sparse" $((abrt_apparent_coresize/50)) $abrt_actual_coresize
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
         popd # $TmpDir
         rlRun "rm -r $TmpDir" 0 "Removing tmp directory"
         rlFileRestore # CFG_FILE CCPP_CFG_FILE
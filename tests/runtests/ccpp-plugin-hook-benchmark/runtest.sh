@@ -0,0 +1,147 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of ccpp-plugin-hook-benchmark
+#   Description: Measures throughput and latency of abrt-hook-ccpp with synthetic cores
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2016 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="ccpp-plugin-hook-benchmark"
+PACKAGE="abrt"
+ABRT_CONF=/etc/abrt/abrt.conf
+CCPP_CONF=/etc/abrt/plugins/CCpp.conf
+AASPD_CONF=/etc/abrt/abrt-action-save-package-data.conf
+
+bench_param BENCH_ITERATIONS 20
+bench_param BENCH_CORE_SIZES_MiB "16 256"
+# Percentage of the core filled with random data, the rest are zeros
+bench_param BENCH_DATA_PERCENTS "100 10"
+
+# Creates a synthetic core file of $1 MiB where only $2 % of the size holds
+# random data and the rest are pages of zeros.
+function make_core
+{
+    local size_MiB=$1
+    local data_MiB=$(( $1 * $2 / 100 ))
+
+    rm -f synthetic.core
+    rlRun "dd if=/dev/urandom of=synthetic.core bs=1M count=$data_MiB status=none"
+    rlRun "truncate -s ${size_MiB}M synthetic.core"
+}
+
+# Prints the value at percentile $1 of numbers in file $2
+function percentile
+{
+    sort -n $2 | awk -v p=$1 '{ v[NR] = $1 } END { i = int((NR * p + 99) / 100); if (i < 1) i = 1; print v[i] }'
+}
+
+# Feeds the synthetic core through the hook BENCH_ITERATIONS times and
+# reports latency percentiles and throughput.
+function run_benchmark
+{
+    local size_MiB=$1
+    local latencies=latencies-$size_MiB-$2.txt
+
+    rm -f $latencies $HOOK_STATS_FILE
+
+    for i in $(seq $BENCH_ITERATIONS); do
+        # The hook ignores repeated crashes of the same executable, every
+        # iteration needs its own binary
+        cp /usr/bin/sleep bench-crasher-$i
+        ./bench-crasher-$i 60 &
+        local pid=$!
+
+        local start=$(bench_now_us)
+        $HOOK 11 0 $pid 0 0 $(date +%s) $pid $pid < synthetic.core
+        local end=$(bench_now_us)
+
+        echo $(( end - start )) >> $latencies
+
+        kill $pid
+        wait $pid 2>/dev/null
+
+        for crash in $ABRT_CONF_DUMP_LOCATION/ccpp-*-$pid; do
+            test -d "$crash" && abrt-cli remove "$crash" > /dev/null
+        done
+        rm -f bench-crasher-$i
+    done
+
+    local p50=$(percentile 50 $latencies)
+    local p99=$(percentile 99 $latencies)
+    local mean=$(awk '{ s += $1 } END { printf "%d", s / NR }' $latencies)
+    local mbps=$(awk -v s=$size_MiB -v m=$mean 'BEGIN { printf "%.1f", s * 1048576 / m }')
+
+    rlLog "core=${size_MiB}MiB data=$2% iterations=$BENCH_ITERATIONS p50=${p50}us p99=${p99}us mean=${mean}us throughput=${mbps}MB/s"
+
+    rlAssertEquals "Every run is recorded in $HOOK_STATS_FILE" "$(wc -l < $HOOK_STATS_FILE)" "$BENCH_ITERATIONS"
+    for phase in config proc dump_dir core package unwind rename notify trim; do
+        rlLog "$phase: mean $(sed -n "s/.*\b${phase}_us=\([0-9]*\).*/\1/p" $HOOK_STATS_FILE | awk '{ s += $1 } END { printf "%d", s / NR }')us"
+    done
+    rlLog "core streaming: mean $(sed -n 's/.*core_MBps=\([0-9.]*\).*/\1/p' $HOOK_STATS_FILE | awk '{ s += $1 } END { printf "%.1f", s / NR }')MB/s"
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        bench_log_params
+        check_prior_crashes
+        load_abrt_conf
+
+        HOOK=$(sed -n 's/^|\([^ ]*\).*/\1/p' /proc/sys/kernel/core_pattern)
+        rlAssertNotEquals "The hook is registered in core_pattern" "_$HOOK" "_"
+
+        TmpDir=$(mktemp -d)
+        HOOK_STATS_FILE=$TmpDir/hook.stats
+        pushd $TmpDir
+
+        rlFileBackup $ABRT_CONF $CCPP_CONF $AASPD_CONF
+        rlRun "augtool set /files${AASPD_CONF}/ProcessUnpackaged yes"
+        rlRun "augtool set /files${ABRT_CONF}/MaxCrashReportsSize 0"
+        rlRun "augtool set /files${CCPP_CONF}/MaxCoreFileSize 0"
+        rlRun "augtool set /files${CCPP_CONF}/MakeCompatCore no"
+        # Unwinding of a sleeping process does not tell anything about
+        # processing of the core dump
+        rlRun "augtool set /files${CCPP_CONF}/CreateCoreBacktrace no"
+        rlRun "augtool set /files${CCPP_CONF}/HookStatsFile $HOOK_STATS_FILE"
+
+        prepare
+    rlPhaseEnd
+
+    for size in $BENCH_CORE_SIZES_MiB; do
+        for percent in $BENCH_DATA_PERCENTS; do
+            rlPhaseStartTest "${size}MiB core with ${percent}% of data"
+                make_core $size $percent
+                run_benchmark $size $percent
+            rlPhaseEnd
+        done
+    done
+
+    rlPhaseStartCleanup
+        rlFileRestore
+        popd # TmpDir
+        rm -rf $TmpDir
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
@@ -89,6 +89,34 @@ rlJournalStart
         rlRun "abrt-cli rm $crash_PATH" 0 "Remove crash directory"
     rlPhaseEnd
 
+    rlPhaseStartTest "DeferCoreBacktrace enabled"
+        rlLogInfo "VerboseLog = 3"
+        rlLogInfo "CreateCoreBacktrace = yes"
+        rlLogInfo "DeferCoreBacktrace = yes"
+        rlRun "echo 'VerboseLog = 3' > $CFG_FILE" 0 "Set VerboseLog = 3"
+        rlRun "echo 'CreateCoreBacktrace = yes' >> $CFG_FILE" 0 "Set CreateCoreBacktrace = yes"
+        rlRun "echo 'DeferCoreBacktrace = yes' >> $CFG_FILE" 0 "Set DeferCoreBacktrace = yes"
+
+        SINCE=$(date +"%Y-%m-%d %T")
+        prepare
+        generate_crash
+        wait_for_hooks
+        get_crash_path
+
+        # The post-create generator was removed from ccpp_event.conf
+        rlAssertNotExists "$crash_PATH/core_backtrace"
+        rlAssertExists "$crash_PATH/coredump"
+
+        rlRun "abrt-action-generate-core-backtrace -d $crash_PATH" 0 "Generate deferred core_backtrace"
+        rlAssertExists "$crash_PATH/core_backtrace"
+        rlRun "./verify_core_backtrace.py $crash_PATH/core_backtrace $(uname -i) $(cat ${crash_PATH}/executable)" 0 "All frames must have required members"
+
+        rlRun "journalctl SYSLOG_IDENTIFIER=abrt-hook-ccpp --since=\"$SINCE\" | grep 'Released crashed process'" 0 "Hook reports the latency"
+        rlRun "journalctl SYSLOG_IDENTIFIER=abrt-hook-ccpp --since=\"$SINCE\" | grep 'Dump time unwinding took'" 1 "No dump time unwinding"
+
+        rlRun "abrt-cli rm $crash_PATH" 0 "Remove crash directory"
+    rlPhaseEnd
+
     rlPhaseStartTest "CreateCoreBacktrace enabled - New PID namespace"
         # I did not use 'unshare --fork --pid will_segfault' because unshare
         # kills itself with the signal the child received.
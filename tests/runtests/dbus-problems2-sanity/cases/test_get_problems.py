@@ -3,8 +3,13 @@
 
 import time
 
+import dbus
+
 import abrt_p2_testing
-from abrt_p2_testing import (wait_for_task_status)
+from abrt_p2_testing import (create_problem,
+                             wait_for_task_status)
+
+DBUS_ERROR_INVALID_ARGS = "org.freedesktop.DBus.Error.InvalidArgs: "
 
 
 class TestGetProblems(abrt_p2_testing.TestCase):
@@ -61,6 +66,74 @@ class TestGetProblems(abrt_p2_testing.TestCase):
         new_problems = self.p2.GetProblems(0x1 | 0x2, dict())
         self.assertEquals(0, len(new_problems))
 
+    def test_get_problems_options(self):
+        paths = []
+        for executable in ["/usr/bin/foo", "/usr/bin/bar", "/usr/bin/bar"]:
+            description = {"analyzer": "problems2testsuite_analyzer",
+                           "type": "problems2testsuite_type",
+                           "reason": "Application has been killed",
+                           "backtrace": "die()",
+                           "executable": executable}
+            paths.append(create_problem(self, self.p2,
+                                        description=description))
+        root_path = create_problem(self, self.root_p2, bus=self.root_bus)
+
+        try:
+            bar = self.p2.GetProblems(0x1,
+                                      {"executable": "/usr/bin/bar",
+                                       "sort_by": "executable"})
+            self.assertEqual(sorted(paths[1:]), sorted(bar))
+            self.assertEqual(sorted(bar), list(bar))
+            self.assertNotIn(root_path, bar)
+
+            first = self.p2.GetProblems(0x0,
+                                        {"executable": "/usr/bin/bar",
+                                         "limit": dbus.UInt32(1)})
+            second = self.p2.GetProblems(0x0,
+                                         {"executable": "/usr/bin/bar",
+                                          "offset": dbus.UInt32(1),
+                                          "limit": dbus.UInt32(1)})
+            self.assertEqual(1, len(first))
+            self.assertEqual(1, len(second))
+            self.assertEqual(sorted(paths[1:]), sorted(first + second))
+
+            everything = self.p2.GetProblems(0x0,
+                                             {"sort_by": "time",
+                                              "sort_descending": True})
+            self.assertEqual(sorted(everything),
+                             sorted(self.p2.GetProblems(0x0, dict())))
+
+            # Equal keys are ordered by paths even in the descending order
+            props = self.p2.GetProblemsProperties(everything,
+                                                  ["FirstOccurrence"])
+            times = {path: props[path]["FirstOccurrence"]
+                     for path in everything}
+            self.assertEqual(sorted(everything,
+                                    key=lambda path: (-times[path], path)),
+                             list(everything))
+
+            oldest = self.p2.GetProblems(0x0, {"sort_by": "time"})
+            self.assertEqual(sorted(oldest,
+                                    key=lambda path: (times[path], path)),
+                             list(oldest))
+
+            future = self.p2.GetProblems(0x0,
+                                         {"since": dbus.UInt64(2 ** 40)})
+            self.assertEqual(0, len(future))
+
+            self.assertRaisesDBusError(DBUS_ERROR_INVALID_ARGS,
+                                       self.p2.GetProblems, 0x0,
+                                       {"colour": "blue"})
+            self.assertRaisesDBusError(DBUS_ERROR_INVALID_ARGS,
+                                       self.p2.GetProblems, 0x0,
+                                       {"limit": "1"})
+            self.assertRaisesDBusError(DBUS_ERROR_INVALID_ARGS,
+                                       self.p2.GetProblems, 0x0,
+                                       {"sort_by": "reason"})
+        finally:
+            self.p2.DeleteProblems(paths)
+            self.root_p2.DeleteProblems([root_path])
+
 
 if __name__ == "__main__":
     abrt_p2_testing.main(TestGetProblems)
@@ -6,6 +6,8 @@ import pwd
 import time
 import socket
 
+import dbus
+
 import abrt_p2_testing
 from abrt_p2_testing import (create_fully_initialized_problem, Problems2Entry)
 
@@ -137,6 +139,31 @@ class TestProblemEntryProperties(abrt_p2_testing.TestCase):
                          len(semantic_elements),
                          "No SemanticElements")
 
+    def test_get_problems_properties(self):
+        p2e = Problems2Entry(self.bus, self.p2_entry_path)
+
+        props = self.p2.GetProblemsProperties(
+                    [self.p2_entry_path, "/org/freedesktop/Problems2/Entry/FAKE"],
+                    ["Executable", "Count", "Package"])
+        self.assertEqual([self.p2_entry_path], list(props.keys()))
+
+        values = props[self.p2_entry_path]
+        self.assertEqual(3, len(values))
+        for name in ["Executable", "Count", "Package"]:
+            self.assertEqual(p2e.getproperty(name), values[name], name)
+
+        props = self.p2.GetProblemsProperties([self.p2_entry_path], [])
+        for name in ["ID", "Type", "Reason", "Elements", "Reports"]:
+            self.assertEqual(p2e.getproperty(name),
+                             props[self.p2_entry_path][name],
+                             name)
+
+        self.assertRaisesRegexp(dbus.exceptions.DBusException,
+                                "org.freedesktop.DBus.Error.InvalidArgs",
+                                self.p2.GetProblemsProperties,
+                                [self.p2_entry_path],
+                                ["Colour"])
+
 
 if __name__ == "__main__":
     abrt_p2_testing.main(TestProblemEntryProperties)
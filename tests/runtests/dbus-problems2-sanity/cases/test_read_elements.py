@@ -89,6 +89,37 @@ class TestReadElements(abrt_p2_testing.TestCase):
 
         self.assertDictContainsSubset(elements, exp)
 
+    def test_read_element_range(self):
+        p2e = Problems2Entry(self.bus, self.p2_entry_path)
+
+        data, size = p2e.ReadElementRange("bytes", 4, 8)
+        self.assertEqual(16, size)
+        self.assertEqual(bytearray([4, 5, 6, 7, 8, 9, 0xA, 0xB]), bytearray(data))
+
+        data, size = p2e.ReadElementRange("bytes", 12, 0)
+        self.assertEqual(bytearray([0xC, 0xD, 0xE, 0xF]), bytearray(data))
+
+        data, size = p2e.ReadElementRange("bytes", 100, 10)
+        self.assertEqual(16, size)
+        self.assertEqual(0, len(data))
+
+        chunk = "ABRT test case huge file "
+        data, size = p2e.ReadElementRange("hugetext", len(chunk), len(chunk))
+        self.assertEqual(os.path.getsize("/tmp/hugetext"), size)
+        self.assertEqual(chunk, bytearray(data).decode())
+
+        # the whole hugetext file exceeds the message size limit
+        data, size = p2e.ReadElementRange("hugetext", 0, 0)
+        self.assertLess(len(data), size)
+        self.assertNotEqual(0, len(data))
+        # a single call never reads more than 1 MiB
+        self.assertLessEqual(len(data), 1024 * 1024)
+
+        for name in ["foo", "/etc/shadow", "../../../../etc/shadow"]:
+            self.assertRaisesRegexp(dbus.exceptions.DBusException,
+                                    "org.freedesktop.DBus.Error.InvalidArgs",
+                                    p2e.ReadElementRange, name, 0, 10)
+
 
 if __name__ == "__main__":
     abrt_p2_testing.main(TestReadElements)
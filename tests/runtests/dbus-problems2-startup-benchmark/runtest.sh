@@ -0,0 +1,100 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of dbus-problems2-startup-benchmark
+#   Description: Measures the time from D-Bus activation of abrt-dbus to the first GetProblems reply with a large dump location
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2016 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="dbus-problems2-startup-benchmark"
+PACKAGE="abrt-dbus"
+
+bench_param BENCH_PROBLEMS 5000
+
+# Activates abrt-dbus by the first call and prints the number of returned
+# problems and the time to the reply in microseconds
+function first_reply
+{
+    killall abrt-dbus 2>/dev/null
+    sleep 1
+
+    local start=$(bench_now_us)
+    dbus-send --system --type=method_call --print-reply \
+              --dest=org.freedesktop.problems /org/freedesktop/Problems2 \
+              org.freedesktop.Problems2.GetProblems int32:0 dict:string:variant: > reply.log
+    local end=$(bench_now_us)
+
+    echo "$(grep -c 'object path' reply.log) $(( end - start ))"
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        bench_log_params
+        check_prior_crashes
+        load_abrt_conf
+
+        TmpDir=$(mktemp -d)
+        rlRun "pushd $TmpDir"
+
+        mkdir template
+        echo "problems2-benchmark" > template/analyzer
+        echo "problems2-benchmark" > template/type
+        echo "Application has been killed" > template/reason
+        echo "/usr/bin/true" > template/executable
+        echo "0" > template/uid
+        echo "1" > template/count
+        date +%s > template/time
+        chmod 0640 template/*
+        chmod 0750 template
+
+        rlLog "Creating $BENCH_PROBLEMS problems"
+        for i in $(seq $BENCH_PROBLEMS); do
+            cp -a template $ABRT_CONF_DUMP_LOCATION/problems2-benchmark-$i
+        done
+    rlPhaseEnd
+
+    rlPhaseStartTest
+        rm -f $ABRT_CONF_DUMP_LOCATION/.problem-info
+        # Problems modified in the last seconds are not cached
+        sleep 3
+        read COLD_PROBLEMS COLD_US <<< "$(first_reply)"
+        rlLog "cold: problems=$COLD_PROBLEMS first_reply=${COLD_US}us"
+        rlAssertGreaterOrEqual "All problems are listed" $COLD_PROBLEMS $BENCH_PROBLEMS
+        rlAssertExists $ABRT_CONF_DUMP_LOCATION/.problem-info
+
+        read WARM_PROBLEMS WARM_US <<< "$(first_reply)"
+        rlLog "cached: problems=$WARM_PROBLEMS first_reply=${WARM_US}us"
+        rlAssertEquals "The cache lists the same problems" $WARM_PROBLEMS $COLD_PROBLEMS
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        killall abrt-dbus 2>/dev/null
+        rm -rf $ABRT_CONF_DUMP_LOCATION/problems2-benchmark-*
+        rlRun "popd"
+        rlRun "rm -r $TmpDir" 0 "Removing tmp directory"
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
@@ -0,0 +1,99 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of dumpoops-benchmark
+#   Description: Measures throughput of abrt-dump-oops on a large synthetic kernel log
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2016 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="dumpoops-benchmark"
+PACKAGE="abrt"
+EXAMPLES_PATH="../../examples"
+
+bench_param BENCH_LOG_SIZE_MiB 1024
+# An oops is inserted after every BENCH_OOPS_EVERY_MiB of ordinary messages
+bench_param BENCH_OOPS_EVERY_MiB 64
+
+# Creates a syslog file of about BENCH_LOG_SIZE_MiB with ordinary kernel and
+# user space messages and a few oopses
+function make_log
+{
+    local filler=filler.log
+
+    # Lines of other programs are skipped early, kernel lines are searched
+    # for all suspicious strings
+    for i in $(seq 1000); do
+        echo "Oct 17 12:34:56 localhost kernel: [ 1234.567890] usb 1-1: new high-speed USB device number $i using xhci_hcd"
+        echo "Oct 17 12:34:56 localhost kernel: [ 1234.567891] EXT4-fs (dm-1): mounted filesystem with ordered data mode. Opts: (null)"
+        echo "Oct 17 12:34:57 localhost systemd[1]: Started Session $i of user root."
+    done > filler.line
+    while [ $(stat -c %s filler.line) -lt $((BENCH_OOPS_EVERY_MiB * 1024 * 1024)) ]; do
+        cat filler.line filler.line > filler.tmp
+        mv filler.tmp filler.line
+    done
+    head -c $((BENCH_OOPS_EVERY_MiB * 1024 * 1024)) filler.line | sed '$d' > $filler
+    rm -f filler.line
+
+    rm -f synthetic.log
+    OOPS_COUNT=0
+    while [ $(( OOPS_COUNT * BENCH_OOPS_EVERY_MiB )) -lt $BENCH_LOG_SIZE_MiB ]; do
+        cat $filler >> synthetic.log
+        cat oops1.test >> synthetic.log
+        OOPS_COUNT=$((OOPS_COUNT + 1))
+    done
+    rm -f $filler
+
+    LOG_SIZE=$(stat -c %s synthetic.log)
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        bench_log_params
+        TmpDir=$(mktemp -d)
+        cp $EXAMPLES_PATH/oops1.test $TmpDir
+        rlRun "pushd $TmpDir"
+
+        rlRun "make_log" 0 "Create ${BENCH_LOG_SIZE_MiB}MiB synthetic log"
+    rlPhaseEnd
+
+    rlPhaseStartTest
+        START=$(bench_now_us)
+        rlRun "abrt-dump-oops -o synthetic.log > oopses.txt 2> found.txt"
+        END=$(bench_now_us)
+
+        ELAPSED_US=$(( END - START ))
+        MBPS=$(awk -v s=$LOG_SIZE -v t=$ELAPSED_US 'BEGIN { printf "%.1f", s / t }')
+        rlLog "log=${LOG_SIZE}B oopses=$OOPS_COUNT time=${ELAPSED_US}us throughput=${MBPS}MB/s"
+
+        rlAssertGrep "Found oopses: [1-9]" found.txt
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        rlRun "popd"
+        rlRun "rm -r $TmpDir" 0 "Removing tmp directory"
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd